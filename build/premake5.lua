@@ -103,6 +103,18 @@ project "launcher"
     filter "not action:vs*"
         removefiles { "../src/launcher/winmain.cpp" }
 
+---------------------------------------
+-- Benchmarks
+
+-- Header-only code from the backends, run by hand when tuning it
+project "hashmap-bench"
+    kind "ConsoleApp"
+    language "C++"
+
+    files {
+        "../src/benchmarks/hashmap_churn.cpp"
+    }
+
 ---------------------------------------
 -- Backends
 
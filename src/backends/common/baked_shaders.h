@@ -1,6 +1,5 @@
 #pragma once
 
-#include <unordered_map>
-#include <string>
+#include "baked_table.h"
 
-extern std::unordered_map<std::string, std::string> baked_shaders;
+extern const baked_table baked_shaders;
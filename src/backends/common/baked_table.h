@@ -0,0 +1,73 @@
+#pragma once
+
+#include "hash.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// A named block of data compiled into the binary
+struct baked_blob
+{
+    const char *name;
+    const uint8_t *data;
+    size_t size;
+};
+
+// A read-only table of baked blobs, written out by a build script along with
+// a perfect hash of their names (see engine/utility/baked_table.lua). It is
+// plain constant data: nothing runs or allocates before main to set it up.
+//
+// A name's FNV-1A picks an entry of `seeds`. A negative seed is the slot of
+// the only name hashing there, as -(slot + 1); any other is the basis to
+// hash the name with again to find its slot among `entries`. Hashes are
+// scaled to the table rather than taken modulo its size, since FNV's low
+// bits barely depend on the input.
+struct baked_table
+{
+    const baked_blob *entries;
+    const int32_t *seeds;
+    size_t count;
+
+    // nullptr when there is no blob called `name`
+    const baked_blob *find(const char *name, size_t len) const;
+    const baked_blob *find(const char *name) const
+    {
+        return find(name, strlen(name));
+    }
+
+    const baked_blob *begin() const
+    {
+        return entries;
+    }
+    const baked_blob *end() const
+    {
+        return entries + count;
+    }
+    size_t size() const
+    {
+        return count;
+    }
+
+private:
+    size_t scale(uint32_t hash) const
+    {
+        return size_t((uint64_t(hash) * count) >> 32);
+    }
+};
+
+inline const baked_blob *baked_table::find(const char *name, size_t len) const
+{
+    if (count == 0)
+        return nullptr;
+
+    int32_t seed = seeds[scale(fnv1a_32(name, len))];
+    size_t slot = seed < 0
+        ? size_t(-(seed + 1))
+        : scale(fnv1a_32(name, len, uint32_t(seed)));
+
+    // Names that were never baked still land somewhere
+    const baked_blob &entry = entries[slot];
+    if (strncmp(entry.name, name, len) != 0 || entry.name[len] != '\0')
+        return nullptr;
+    return &entry;
+}
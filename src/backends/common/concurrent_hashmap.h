@@ -0,0 +1,176 @@
+#pragma once
+
+#include "hashmap.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+// A hashmap any number of threads may read and write at the same time.
+//
+// Keys are spread over `shard_count` hashmaps by a fast hash of their own,
+// each shard behind its own lock, so threads only wait on each other when
+// they touch the same shard, and then only for one lookup. A seqlock would
+// spare readers the lock, but hashmap moves entries around as it grows and
+// values such as strings can't be copied out while that happens.
+//
+// Values are returned by copy since another thread may move or remove an
+// entry the moment the lock is released. Keep them small: handles,
+// pointers, shared_ptrs.
+template <typename K, typename V, typename Hasher = HashPolicy::DosResistant, size_t shard_count = 16>
+class concurrent_hashmap
+{
+    static_assert(!std::is_void<V>::value, "concurrent_hashmap needs a value type");
+    static_assert(shard_count != 0 && (shard_count & (shard_count - 1)) == 0, "shard_count must be a power of two");
+
+    using map_type = hashmap<K, V, Hasher>;
+
+public:
+    using lookup_type = typename map_type::lookup_type;
+    using optional_value_type = typename map_type::optional_value_type;
+
+    concurrent_hashmap() = default;
+    concurrent_hashmap(const concurrent_hashmap &) = delete;
+    concurrent_hashmap &operator=(const concurrent_hashmap &) = delete;
+
+    optional_value_type get(lookup_type key) const;
+    bool contains(lookup_type key) const;
+
+    // The value already stored for `key`, or `value` after storing it. When
+    // threads race to add the same key, all of them get the first one's.
+    V get_or_insert(K key, V value);
+    // Like get_or_insert, but only calls `make` when the key is missing. It
+    // runs under the shard's lock, so each key is made exactly once, and
+    // other threads using the shard wait for it. Loading an asset should
+    // happen outside; store a handle the loader fills in, or check with
+    // get() first and accept that two threads may both load.
+    template <typename F>
+    V get_or_insert_with(K key, F &&make);
+
+    // Returns the value `key` had before, if any
+    optional_value_type insert(K key, V value);
+    optional_value_type remove(lookup_type key);
+    void clear();
+
+    // Only exact while no other thread is writing
+    size_t size() const;
+
+    // Calls fn(key, value) for every entry, one shard at a time and under
+    // its lock. fn must not use the map.
+    template <typename F>
+    void for_each(F &&fn) const;
+
+private:
+    struct shard
+    {
+        std::mutex lock;
+        map_type map;
+        // Keeps neighbouring shards' locks off each other's cache lines
+        char pad[64];
+    };
+
+    template <typename Q>
+    shard &shard_for(const Q &key) const;
+
+    mutable shard shards[shard_count];
+};
+
+template <typename K, typename V, typename Hasher, size_t shard_count>
+template <typename Q>
+inline auto concurrent_hashmap<K, V, Hasher, shard_count>::shard_for(const Q &key) const -> shard &
+{
+    // Spreading keys over shards needs no protection against crafted
+    // collisions, the maps themselves use Hasher
+    WyHash64 h;
+    hash_apply(key, h);
+    return shards[size_t(uint64_t(h) >> 32) & (shard_count - 1)];
+}
+
+template <typename K, typename V, typename Hasher, size_t shard_count>
+inline auto concurrent_hashmap<K, V, Hasher, shard_count>::get(lookup_type key) const -> optional_value_type
+{
+    shard &s = shard_for(key);
+    std::lock_guard<std::mutex> guard(s.lock);
+    if (const V *value = s.map.get(key))
+        return *value;
+    return {};
+}
+
+template <typename K, typename V, typename Hasher, size_t shard_count>
+inline bool concurrent_hashmap<K, V, Hasher, shard_count>::contains(lookup_type key) const
+{
+    shard &s = shard_for(key);
+    std::lock_guard<std::mutex> guard(s.lock);
+    return s.map.count(key) != 0;
+}
+
+template <typename K, typename V, typename Hasher, size_t shard_count>
+inline V concurrent_hashmap<K, V, Hasher, shard_count>::get_or_insert(K key, V value)
+{
+    shard &s = shard_for(key);
+    std::lock_guard<std::mutex> guard(s.lock);
+    return s.map.try_emplace(std::move(key), std::move(value)).first->second;
+}
+
+template <typename K, typename V, typename Hasher, size_t shard_count>
+template <typename F>
+inline V concurrent_hashmap<K, V, Hasher, shard_count>::get_or_insert_with(K key, F &&make)
+{
+    shard &s = shard_for(key);
+    std::lock_guard<std::mutex> guard(s.lock);
+    if (V *value = s.map.get_mut(key))
+        return *value;
+    return s.map.try_emplace(std::move(key), make()).first->second;
+}
+
+template <typename K, typename V, typename Hasher, size_t shard_count>
+inline auto concurrent_hashmap<K, V, Hasher, shard_count>::insert(K key, V value) -> optional_value_type
+{
+    shard &s = shard_for(key);
+    std::lock_guard<std::mutex> guard(s.lock);
+    return s.map.insert(std::move(key), std::move(value));
+}
+
+template <typename K, typename V, typename Hasher, size_t shard_count>
+inline auto concurrent_hashmap<K, V, Hasher, shard_count>::remove(lookup_type key) -> optional_value_type
+{
+    shard &s = shard_for(key);
+    std::lock_guard<std::mutex> guard(s.lock);
+    return s.map.remove(key);
+}
+
+template <typename K, typename V, typename Hasher, size_t shard_count>
+inline void concurrent_hashmap<K, V, Hasher, shard_count>::clear()
+{
+    for (shard &s : shards)
+    {
+        std::lock_guard<std::mutex> guard(s.lock);
+        s.map.clear();
+    }
+}
+
+template <typename K, typename V, typename Hasher, size_t shard_count>
+inline size_t concurrent_hashmap<K, V, Hasher, shard_count>::size() const
+{
+    size_t total = 0;
+    for (shard &s : shards)
+    {
+        std::lock_guard<std::mutex> guard(s.lock);
+        total += s.map.size();
+    }
+    return total;
+}
+
+template <typename K, typename V, typename Hasher, size_t shard_count>
+template <typename F>
+inline void concurrent_hashmap<K, V, Hasher, shard_count>::for_each(F &&fn) const
+{
+    for (shard &s : shards)
+    {
+        std::lock_guard<std::mutex> guard(s.lock);
+        const map_type &map = s.map;
+        for (auto &entry : map)
+            fn(entry.first, entry.second);
+    }
+}
@@ -0,0 +1,625 @@
+#pragma once
+
+#include "hashmap.h"
+#include "object_pool.h"
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+// An object_pool that any number of threads may allocate from and free into
+// at the same time, with the same handles.
+//
+// Every object has a fixed cell in a bucket and keeps the handle slot of
+// that cell for good, so free lists only need to hold slot numbers. Each
+// thread has its own free list. When it runs dry the thread takes a batch
+// of slots that other threads gave back, or failing that claims fresh ones
+// past the end of the newest bucket. A thread that frees more than it
+// allocates hands batches back the same way, and the free list of a thread
+// that has exited is taken over by the next one to run dry. Neither path
+// takes a lock, except a thread's first use of the pool, taking over an
+// exited thread's list and the rare commit of more of a bucket's memory.
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+class concurrent_object_pool
+{
+public:
+    using allocation = ::pool_allocation;
+
+    static const uint32_t HANDLE_SLOT_BITS = 24;
+    static const uint32_t HANDLE_SLOT_MASK = (1u << HANDLE_SLOT_BITS) - 1;
+    static const uint32_t MAX_HANDLES = HANDLE_SLOT_MASK;
+
+    concurrent_object_pool();
+    ~concurrent_object_pool();
+
+    concurrent_object_pool(const concurrent_object_pool &) = delete;
+    concurrent_object_pool &operator=(const concurrent_object_pool &) = delete;
+
+    // Fails (with null memory) once MAX_HANDLES objects are alive
+    auto alloc() -> allocation;
+    // May be called from any thread, not just the one that allocated
+    auto free(const allocation &alloc) -> void;
+
+    // Allocates `count` objects into `out`. Large requests get a run of
+    // fresh, adjacent cells of their own instead of whatever the free list
+    // holds. Returns how many were allocated, fewer only when out of handles.
+    auto alloc_n(uint32_t count, allocation *out) -> uint32_t;
+    auto free_n(const allocation *allocs, uint32_t count) -> void;
+    auto resolve(uint32_t handle) const -> void *;
+
+    // Safe to call while other threads use the pool, though counts taken
+    // then may be off by what they do meanwhile
+    auto usage() -> pool_usage;
+
+    // Gives the object memory of buckets without live objects back to the
+    // OS. Their cells stay on the free lists and are committed again by the
+    // first alloc to reach one. Other threads may keep using the pool, but
+    // only one thread at a time may trim. Cheap enough for every frame: it
+    // only scans the buckets' cell states once a bucket's worth of objects
+    // was freed since the last scan, or once frees stop for a call.
+    auto trim() -> void;
+
+private:
+    // Slots moved between threads at a time
+    static const uint32_t BATCH = 256;
+    static const uint32_t MAX_BUCKETS = (MAX_HANDLES + objects_per_bucket - 1) / objects_per_bucket;
+    // Set in a cell's state while its object is alive, next to the generation
+    static const uint32_t ALIVE = 0x100;
+
+    using obj_storage = std::aligned_storage_t<(obj_size < 4 ? 4 : obj_size), (obj_align < 4 ? 4 : obj_align)>;
+    // Reserved in full, committed as threads claim fresh cells (see
+    // reserved_region). Committed states read as zero, generation 0 and
+    // not alive, so they need no initialisation.
+    struct bucket_t
+    {
+        reserved_region objects;
+        reserved_region states;
+        std::atomic<uint32_t> committed_cells{ 0 };
+        // Set while trim() checks the bucket and after it decommitted the
+        // objects, until an alloc commits them again. Guarded by grow_lock.
+        std::atomic<bool> parked{ false };
+        std::mutex grow_lock;
+
+        obj_storage *object(uint32_t cell)
+        {
+            return (obj_storage *)objects.data() + cell;
+        }
+        std::atomic<uint32_t> &state(uint32_t cell)
+        {
+            return ((std::atomic<uint32_t> *)states.data())[cell];
+        }
+    };
+    struct slot_batch
+    {
+        slot_batch *next;
+        uint32_t count;
+        uint32_t slots[BATCH];
+    };
+    // Shared with the owning thread's exit guard, which may outlive the pool
+    struct thread_cache
+    {
+        // Oldest first, so a slot's generation comes around as late as possible
+        std::deque<uint32_t> free_slots;
+        // Only written by the owning thread, read by usage()
+        std::atomic<uint64_t> allocs{ 0 };
+        std::atomic<uint64_t> frees{ 0 };
+        // Set when the owning thread exits, after which nothing else
+        // touches the cache until the pool adopts it
+        std::atomic<bool> exited{ false };
+        // The pool's count of exited caches it hasn't adopted yet
+        std::shared_ptr<std::atomic<uint32_t>> pool_exited;
+    };
+
+    thread_cache &local();
+    bool refill(thread_cache &cache);
+    // Moves the free lists of exited threads' caches into `cache`
+    bool adopt_exited(thread_cache &cache);
+    // Claims `count` never used slots, adding them to the back of the
+    // cache's free list or, in order, to its front
+    bool claim_fresh(thread_cache &cache, uint32_t count, bool front);
+    bool take_unbacked(uint32_t count, uint32_t &first, uint32_t &last);
+    void return_unbacked(uint32_t first, uint32_t last);
+    allocation take(thread_cache &cache);
+    void release(thread_cache &cache, uint32_t handle);
+    void give_back(thread_cache &cache);
+    void push_batches(slot_batch *first);
+    bucket_t *ensure_bucket(uint32_t index);
+    bool ensure_cells(bucket_t *bucket, uint32_t count);
+    // Commits a trimmed bucket's objects again
+    bool unpark(bucket_t *bucket);
+
+    bucket_t *bucket_at(uint32_t index) const
+    {
+        return buckets[index].load(std::memory_order_acquire);
+    }
+
+    static uint64_t next_id()
+    {
+        static std::atomic<uint64_t> counter{ 0 };
+        return ++counter;
+    }
+
+    uint64_t id;
+    std::unique_ptr<std::atomic<bucket_t *>[]> buckets;
+    // First slot no thread has claimed yet
+    std::atomic<uint32_t> next_fresh;
+    // Batches of slots freed by threads that had more than they needed
+    std::atomic<slot_batch *> returned;
+
+    std::mutex registry_lock;
+    std::vector<std::shared_ptr<thread_cache>> caches;
+    std::shared_ptr<std::atomic<uint32_t>> exited_caches;
+    // Counts of adopted caches, so usage() still sees them
+    uint64_t adopted_allocs;
+    uint64_t adopted_frees;
+    // Claimed slot ranges whose memory couldn't be committed, handed out
+    // again before claiming past next_fresh. Guarded by registry_lock.
+    std::vector<std::pair<uint32_t, uint32_t>> unbacked;
+    std::atomic<bool> has_unbacked;
+    // Frees counted by the last trim() that scanned the buckets, and by
+    // the last trim() at all
+    uint64_t trimmed_frees;
+    uint64_t seen_frees;
+};
+
+// Default to 4MB buckets, like object_pool_t, committed as they fill
+template <typename T>
+using concurrent_object_pool_t = concurrent_object_pool<sizeof(T), alignof(T), 4 * 1024 * 1024 / sizeof(T)>;
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::concurrent_object_pool()
+    : id(next_id()), buckets(new std::atomic<bucket_t *>[MAX_BUCKETS]), next_fresh(0), returned(nullptr),
+      exited_caches(std::make_shared<std::atomic<uint32_t>>(0)), adopted_allocs(0), adopted_frees(0), has_unbacked(false),
+      trimmed_frees(0), seen_frees(0)
+{
+    for (uint32_t i = 0; i < MAX_BUCKETS; ++i)
+        buckets[i].store(nullptr, std::memory_order_relaxed);
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::~concurrent_object_pool()
+{
+    for (uint32_t i = 0; i < MAX_BUCKETS; ++i)
+        delete buckets[i].load(std::memory_order_relaxed);
+
+    slot_batch *batch = returned.load(std::memory_order_relaxed);
+    while (batch)
+    {
+        slot_batch *next = batch->next;
+        delete batch;
+        batch = next;
+    }
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline auto concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::alloc() -> allocation
+{
+    thread_cache &cache = local();
+    if (cache.free_slots.empty() && !refill(cache))
+        return allocation{};
+    return take(cache);
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline auto concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::alloc_n(uint32_t count, allocation *out) -> uint32_t
+{
+    thread_cache &cache = local();
+    if (count >= BATCH)
+        claim_fresh(cache, count, true);
+
+    uint32_t done = 0;
+    while (done < count)
+    {
+        if (cache.free_slots.empty() && !refill(cache))
+            break;
+        out[done] = take(cache);
+        if (!out[done].memory)
+            break;
+        ++done;
+    }
+    return done;
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline auto concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::take(thread_cache &cache) -> allocation
+{
+    allocation alloc{};
+    uint32_t slot = cache.free_slots.front();
+    cache.free_slots.pop_front();
+
+    bucket_t *bucket = bucket_at(slot / objects_per_bucket);
+    uint32_t cell = slot % objects_per_bucket;
+    uint32_t generation = bucket->state(cell).load(std::memory_order_relaxed) & 0xFF;
+    // Marking the cell alive before looking at `parked` pairs with trim()
+    // doing the opposite, so at least one of the two sees the other
+    bucket->state(cell).store(generation | ALIVE, std::memory_order_seq_cst);
+    if (bucket->parked.load(std::memory_order_seq_cst) && !unpark(bucket))
+    {
+        bucket->state(cell).store(generation, std::memory_order_release);
+        cache.free_slots.push_front(slot);
+        return alloc;
+    }
+
+    alloc.memory = bucket->object(cell);
+    alloc.handle = (generation << HANDLE_SLOT_BITS) | (slot + 1);
+    cache.allocs.store(cache.allocs.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return alloc;
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline auto concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::free(const allocation &alloc) -> void
+{
+    release(local(), alloc.handle);
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline auto concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::free_n(const allocation *allocs, uint32_t count) -> void
+{
+    thread_cache &cache = local();
+    for (uint32_t i = 0; i < count; ++i)
+        release(cache, allocs[i].handle);
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline void concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::release(thread_cache &cache, uint32_t handle)
+{
+    uint32_t slot = (handle & HANDLE_SLOT_MASK) - 1;
+    bucket_t *bucket = bucket_at(slot / objects_per_bucket);
+    uint32_t cell = slot % objects_per_bucket;
+    uint32_t generation = (bucket->state(cell).load(std::memory_order_relaxed) + 1) & 0xFF;
+    bucket->state(cell).store(generation, std::memory_order_release);
+
+    cache.frees.store(cache.frees.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    cache.free_slots.push_back(slot);
+    if (cache.free_slots.size() >= 2 * BATCH)
+        give_back(cache);
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline auto concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::resolve(uint32_t handle) const -> void *
+{
+    uint32_t index = handle & HANDLE_SLOT_MASK;
+    if (index == 0)
+        return nullptr;
+
+    uint32_t slot = index - 1;
+    bucket_t *bucket = bucket_at(slot / objects_per_bucket);
+    if (!bucket)
+        return nullptr;
+
+    // Cells past the committed ones aren't mapped yet
+    uint32_t cell = slot % objects_per_bucket;
+    if (cell >= bucket->committed_cells.load(std::memory_order_acquire))
+        return nullptr;
+    if (bucket->state(cell).load(std::memory_order_acquire) != ((handle >> HANDLE_SLOT_BITS) | ALIVE))
+        return nullptr;
+    return bucket->object(cell);
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline auto concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::usage() -> pool_usage
+{
+    pool_usage u{};
+    {
+        std::lock_guard<std::mutex> guard(registry_lock);
+        u.allocs = adopted_allocs;
+        u.frees = adopted_frees;
+        for (auto &c : caches)
+        {
+            u.allocs += c->allocs.load(std::memory_order_relaxed);
+            u.frees += c->frees.load(std::memory_order_relaxed);
+        }
+    }
+    u.live = u.allocs > u.frees ? uint32_t(u.allocs - u.frees) : 0;
+
+    // Every claimed slot is either alive or on some thread's free list
+    uint32_t claimed = next_fresh.load(std::memory_order_relaxed);
+    claimed = claimed < MAX_HANDLES ? claimed : MAX_HANDLES;
+    u.free_cells = claimed > u.live ? claimed - u.live : 0;
+
+    for (uint32_t i = 0; i < MAX_BUCKETS; ++i)
+    {
+        bucket_t *bucket = bucket_at(i);
+        if (!bucket)
+            continue;
+
+        std::lock_guard<std::mutex> guard(bucket->grow_lock);
+        u.buckets++;
+        u.reserved_bytes += bucket->objects.capacity() + bucket->states.capacity();
+        u.committed_bytes += bucket->objects.committed() + bucket->states.committed();
+    }
+    return u;
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline auto concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::trim() -> void
+{
+    uint64_t frees;
+    {
+        std::lock_guard<std::mutex> guard(registry_lock);
+        frees = adopted_frees;
+        for (auto &c : caches)
+            frees += c->frees.load(std::memory_order_relaxed);
+    }
+    bool quiet = frees == seen_frees;
+    seen_frees = frees;
+    if (frees == trimmed_frees || (!quiet && frees - trimmed_frees < objects_per_bucket))
+        return;
+    trimmed_frees = frees;
+
+    uint32_t claimed = next_fresh.load(std::memory_order_relaxed);
+    claimed = claimed < MAX_HANDLES ? claimed : MAX_HANDLES;
+    for (uint32_t i = 0; i < (claimed + objects_per_bucket - 1) / objects_per_bucket; ++i)
+    {
+        bucket_t *bucket = bucket_at(i);
+        if (!bucket || bucket->parked.load(std::memory_order_relaxed))
+            continue;
+
+        std::lock_guard<std::mutex> guard(bucket->grow_lock);
+        if (bucket->objects.committed() == 0)
+            continue;
+
+        // An alloc that raced past this sees `parked` and waits on grow_lock
+        bucket->parked.store(true, std::memory_order_seq_cst);
+        uint32_t cells = bucket->committed_cells.load(std::memory_order_relaxed);
+        bool empty = true;
+        for (uint32_t cell = 0; cell < cells && empty; ++cell)
+            empty = (bucket->state(cell).load(std::memory_order_seq_cst) & ALIVE) == 0;
+
+        if (empty)
+            bucket->objects.decommit();
+        else
+            bucket->parked.store(false, std::memory_order_relaxed);
+    }
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline bool concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::unpark(bucket_t *bucket)
+{
+    std::lock_guard<std::mutex> guard(bucket->grow_lock);
+    if (!bucket->parked.load(std::memory_order_relaxed))
+        return true;
+
+    // Every cell a free list can hand out was committed before
+    size_t cells = bucket->committed_cells.load(std::memory_order_relaxed);
+    if (!bucket->objects.commit(cells * sizeof(obj_storage)))
+        return false;
+    bucket->parked.store(false, std::memory_order_release);
+    return true;
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline bool concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::refill(thread_cache &cache)
+{
+    // Taking the whole list and pushing the rest back means a batch is never
+    // popped while another thread looks at it, so there's no ABA problem
+    if (slot_batch *batch = returned.exchange(nullptr, std::memory_order_acquire))
+    {
+        cache.free_slots.insert(cache.free_slots.end(), batch->slots, batch->slots + batch->count);
+        if (batch->next)
+            push_batches(batch->next);
+        delete batch;
+        return true;
+    }
+    if (exited_caches->load(std::memory_order_acquire) != 0 && adopt_exited(cache))
+        return true;
+    return claim_fresh(cache, BATCH, false);
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline bool concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::adopt_exited(thread_cache &cache)
+{
+    std::lock_guard<std::mutex> guard(registry_lock);
+    size_t kept = 0;
+    for (size_t i = 0; i < caches.size(); ++i)
+    {
+        thread_cache &c = *caches[i];
+        if (&c == &cache || !c.exited.load(std::memory_order_acquire))
+        {
+            caches[kept++] = std::move(caches[i]);
+            continue;
+        }
+
+        cache.free_slots.insert(cache.free_slots.end(), c.free_slots.begin(), c.free_slots.end());
+        adopted_allocs += c.allocs.load(std::memory_order_relaxed);
+        adopted_frees += c.frees.load(std::memory_order_relaxed);
+        exited_caches->fetch_sub(1, std::memory_order_relaxed);
+    }
+    caches.resize(kept);
+    return !cache.free_slots.empty();
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline bool concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::claim_fresh(thread_cache &cache, uint32_t count, bool front)
+{
+    uint32_t first, last;
+    if (!take_unbacked(count, first, last))
+    {
+        first = next_fresh.load(std::memory_order_relaxed);
+        do
+        {
+            if (first >= MAX_HANDLES)
+                return false;
+            last = MAX_HANDLES - first > count ? first + count : MAX_HANDLES;
+        } while (!next_fresh.compare_exchange_weak(first, last, std::memory_order_relaxed));
+    }
+
+    for (uint32_t b = first / objects_per_bucket; b <= (last - 1) / objects_per_bucket; ++b)
+    {
+        bucket_t *bucket = ensure_bucket(b);
+        uint32_t end = last - b * objects_per_bucket;
+        if (!bucket || !ensure_cells(bucket, end < objects_per_bucket ? end : objects_per_bucket))
+        {
+            return_unbacked(first, last);
+            return false;
+        }
+    }
+    if (front)
+    {
+        for (uint32_t slot = last; slot-- > first;)
+            cache.free_slots.push_front(slot);
+    }
+    else
+    {
+        for (uint32_t slot = first; slot < last; ++slot)
+            cache.free_slots.push_back(slot);
+    }
+    return true;
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline bool concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::take_unbacked(uint32_t count, uint32_t &first, uint32_t &last)
+{
+    if (!has_unbacked.load(std::memory_order_acquire))
+        return false;
+
+    std::lock_guard<std::mutex> guard(registry_lock);
+    if (unbacked.empty())
+        return false;
+
+    auto &range = unbacked.back();
+    first = range.first;
+    last = range.second - range.first > count ? range.first + count : range.second;
+    range.first = last;
+    if (range.first == range.second)
+        unbacked.pop_back();
+    has_unbacked.store(!unbacked.empty(), std::memory_order_release);
+    return true;
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline void concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::return_unbacked(uint32_t first, uint32_t last)
+{
+    // Memory ran out. Undo the claim if nobody claimed past it since, else
+    // keep the range for whoever claims next: its slots can't go on
+    // `returned`, which only holds slots with memory behind them.
+    uint32_t expected = last;
+    if (next_fresh.compare_exchange_strong(expected, first, std::memory_order_relaxed))
+        return;
+
+    std::lock_guard<std::mutex> guard(registry_lock);
+    unbacked.emplace_back(first, last);
+    has_unbacked.store(true, std::memory_order_release);
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline void concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::give_back(thread_cache &cache)
+{
+    auto *batch = new slot_batch;
+    batch->next = nullptr;
+    batch->count = BATCH;
+    std::copy(cache.free_slots.begin(), cache.free_slots.begin() + BATCH, batch->slots);
+    cache.free_slots.erase(cache.free_slots.begin(), cache.free_slots.begin() + BATCH);
+    push_batches(batch);
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline void concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::push_batches(slot_batch *first)
+{
+    slot_batch *last = first;
+    while (last->next)
+        last = last->next;
+
+    slot_batch *head = returned.load(std::memory_order_relaxed);
+    do
+    {
+        last->next = head;
+    } while (!returned.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline auto concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::ensure_bucket(uint32_t index) -> bucket_t *
+{
+    bucket_t *bucket = bucket_at(index);
+    if (bucket)
+        return bucket;
+
+    // Two threads may race to create the same bucket, the loser drops its own
+    std::unique_ptr<bucket_t> fresh{ new bucket_t };
+    if (!fresh->objects.reserve(size_t(objects_per_bucket) * sizeof(obj_storage)) ||
+        !fresh->states.reserve(size_t(objects_per_bucket) * sizeof(uint32_t)))
+        return nullptr;
+    if (buckets[index].compare_exchange_strong(bucket, fresh.get(), std::memory_order_acq_rel))
+        return fresh.release();
+    return bucket;
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline bool concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::ensure_cells(bucket_t *bucket, uint32_t count)
+{
+    if (count <= bucket->committed_cells.load(std::memory_order_acquire))
+        return true;
+
+    // Rare, commits grow geometrically
+    std::lock_guard<std::mutex> guard(bucket->grow_lock);
+    if (!bucket->objects.commit(size_t(count) * sizeof(obj_storage)) ||
+        !bucket->states.commit(size_t(count) * sizeof(uint32_t)))
+        return false;
+
+    size_t cells = bucket->objects.committed() / sizeof(obj_storage);
+    size_t states = bucket->states.committed() / sizeof(uint32_t);
+    cells = cells < states ? cells : states;
+    cells = cells < objects_per_bucket ? cells : objects_per_bucket;
+    bucket->committed_cells.store(uint32_t(cells), std::memory_order_release);
+    return true;
+}
+
+template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline auto concurrent_object_pool<obj_size, obj_align, objects_per_bucket>::local() -> thread_cache &
+{
+    // The last pool used covers the usual one-pool case, as in
+    // mutation_queues, and the thread's map covers threads that switch
+    // between pools. Ids are never reused, so entries can't outlive their pool.
+    struct cache_entry
+    {
+        uint64_t id;
+        thread_cache *cache;
+    };
+    // Marks the thread's caches exited when it ends, so the slots on their
+    // free lists go back to the pools
+    struct exit_guard
+    {
+        hashmap<uint64_t, std::shared_ptr<thread_cache>, HashPolicy::Fast> caches;
+
+        ~exit_guard()
+        {
+            for (auto &c : caches)
+            {
+                c.second->exited.store(true, std::memory_order_release);
+                c.second->pool_exited->fetch_add(1, std::memory_order_release);
+            }
+        }
+    };
+    static thread_local cache_entry last = { 0, nullptr };
+    static thread_local exit_guard exiting;
+    if (last.id == id)
+        return *last.cache;
+
+    auto &mine = exiting.caches;
+    auto known = mine.find(id);
+    if (known != mine.end())
+    {
+        last = { id, known->second.get() };
+        return *last.cache;
+    }
+
+    // First use of this pool on this thread
+    std::shared_ptr<thread_cache> fresh = std::make_shared<thread_cache>();
+    fresh->pool_exited = exited_caches;
+    {
+        std::lock_guard<std::mutex> guard(registry_lock);
+        caches.push_back(fresh);
+    }
+
+    // Drop caches of pools that are gone, which only the guard still holds
+    for (auto it = mine.begin(); it != mine.end();)
+        it = it->second.use_count() == 1 ? mine.erase(it) : std::next(it);
+
+    last = { id, fresh.get() };
+    mine.emplace(id, std::move(fresh));
+    return *last.cache;
+}
@@ -0,0 +1,502 @@
+#pragma once
+
+#include "hashmap.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GROUP_HASHMAP_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define GROUP_HASHMAP_NEON
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace group_hashmap_details
+{
+    static const size_t GROUP_SIZE = 16;
+
+    // Control bytes of full slots hold the low 7 bits of the key's hash,
+    // the sign bit marks free ones
+    static const int8_t EMPTY = -128;
+    static const int8_t DELETED = -2;
+
+    inline uint32_t trailing_zeros(uint64_t x)
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long index;
+#if defined(_M_X64) || defined(_M_ARM64)
+        _BitScanForward64(&index, x);
+#else
+        if (_BitScanForward(&index, uint32_t(x)))
+            return index;
+        _BitScanForward(&index, uint32_t(x >> 32));
+        index += 32;
+#endif
+        return index;
+#else
+        return uint32_t(__builtin_ctzll(x));
+#endif
+    }
+
+    // The slots of a group that matched, lowest first. Each slot takes
+    // 1 << shift bits, of which at most one is set.
+    template <uint32_t shift>
+    struct match_mask
+    {
+        uint64_t bits;
+
+        explicit operator bool() const
+        {
+            return bits != 0;
+        }
+        uint32_t lowest() const
+        {
+            return trailing_zeros(bits) >> shift;
+        }
+        void clear_lowest()
+        {
+            bits &= bits - 1;
+        }
+    };
+
+#if defined(GROUP_HASHMAP_SSE2)
+    struct group
+    {
+        using mask = match_mask<0>;
+
+        explicit group(const int8_t *pos)
+            : ctrl(_mm_loadu_si128((const __m128i *)pos))
+        {
+        }
+
+        mask match(int8_t h2) const
+        {
+            return mask{ uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl))) };
+        }
+        mask match_empty() const
+        {
+            return match(EMPTY);
+        }
+        mask match_free() const
+        {
+            return mask{ uint16_t(_mm_movemask_epi8(ctrl)) };
+        }
+
+        __m128i ctrl;
+    };
+#elif defined(GROUP_HASHMAP_NEON)
+    struct group
+    {
+        // NEON has no movemask, narrowing the comparison leaves a nibble
+        // per slot instead
+        using mask = match_mask<2>;
+
+        explicit group(const int8_t *pos)
+            : ctrl(vld1q_s8(pos))
+        {
+        }
+
+        static mask to_mask(uint8x16_t matched)
+        {
+            uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(matched), 4);
+            return mask{ vget_lane_u64(vreinterpret_u64_u8(nibbles), 0) & 0x8888888888888888ull };
+        }
+
+        mask match(int8_t h2) const
+        {
+            return to_mask(vceqq_s8(ctrl, vdupq_n_s8(h2)));
+        }
+        mask match_empty() const
+        {
+            return match(EMPTY);
+        }
+        mask match_free() const
+        {
+            return to_mask(vcltq_s8(ctrl, vdupq_n_s8(0)));
+        }
+
+        int8x16_t ctrl;
+    };
+#else
+    struct group
+    {
+        using mask = match_mask<0>;
+
+        explicit group(const int8_t *pos)
+        {
+            memcpy(ctrl, pos, GROUP_SIZE);
+        }
+
+        mask match(int8_t h2) const
+        {
+            uint64_t bits = 0;
+            for (size_t i = 0; i < GROUP_SIZE; ++i)
+                bits |= uint64_t(ctrl[i] == h2) << i;
+            return mask{ bits };
+        }
+        mask match_empty() const
+        {
+            return match(EMPTY);
+        }
+        mask match_free() const
+        {
+            uint64_t bits = 0;
+            for (size_t i = 0; i < GROUP_SIZE; ++i)
+                bits |= uint64_t(ctrl[i] < 0) << i;
+            return mask{ bits };
+        }
+
+        int8_t ctrl[GROUP_SIZE];
+    };
+#endif
+
+    template <typename K, typename V>
+    struct slot
+    {
+        K key;
+        V value;
+    };
+
+    template <typename K>
+    struct slot<K, void>
+    {
+        K key;
+    };
+}
+
+// A drop-in alternative to hashmap where only insert/remove/get are used,
+// laid out like SwissTable. Next to the slots sits an array of one control byte per slot
+// holding 7 bits of the key's hash, and lookups compare a whole group of
+// 16 control bytes at once (SSE2 or NEON), touching only the slots whose
+// byte matched. A miss usually never reads a slot at all.
+//
+// Groups are aligned and their count is a power of two, so probing jumps
+// between whole groups. A probe ends at the first group with an empty
+// slot, which lets remove() leave a slot empty rather than deleted unless
+// its group is full.
+template <typename K, typename V, typename Hasher = HashPolicy::DosResistant>
+class group_hashmap
+{
+    using slot_t = group_hashmap_details::slot<K, V>;
+    using group = group_hashmap_details::group;
+    using key_traits = hashmap_key_traits<K>;
+    using value_traits = hashmap_value_traits<V>;
+    using hash_t = typename Hasher::result_type;
+    static const size_t GROUP_SIZE = group_hashmap_details::GROUP_SIZE;
+    static const size_t NOT_FOUND = ~size_t(0);
+
+    static_assert(alignof(slot_t) <= alignof(max_align_t), "Over-aligned keys and values aren't supported");
+
+public:
+    using value_type = typename value_traits::value_type;
+    using optional_value_type = typename value_traits::optional_value_type;
+    using optional_value_ref = typename value_traits::optional_value_ref;
+    using optional_value_cref = typename value_traits::optional_value_cref;
+    using lookup_type = typename key_traits::lookup_type;
+
+    group_hashmap(const Hasher &hasher = Hasher{});
+    ~group_hashmap();
+
+    group_hashmap(const group_hashmap &) = delete;
+    group_hashmap &operator=(const group_hashmap &) = delete;
+
+    optional_value_type insert(K key, value_type value);
+    optional_value_type remove(lookup_type key);
+    void clear();
+    void shrink();
+
+    optional_value_cref get(lookup_type key) const;
+    optional_value_ref get_mut(lookup_type key) const;
+
+private:
+    template <typename Q>
+    size_t hash_key(const Q &key) const;
+    static int8_t h2(size_t hash)
+    {
+        return int8_t(hash & 0x7F);
+    }
+    // 7/8 of the slots may be used before growing
+    static size_t max_used(size_t capacity)
+    {
+        return capacity - capacity / 8;
+    }
+
+    size_t find(lookup_type key) const;
+    size_t find_free(size_t hash) const;
+    void construct(size_t idx, K &&key, value_type &&value, std::true_type);
+    void construct(size_t idx, K &&key, value_type &&value, std::false_type);
+    optional_value_type take(size_t idx, std::true_type);
+    optional_value_type take(size_t idx, std::false_type);
+    optional_value_ref found(size_t idx, std::true_type) const;
+    optional_value_ref found(size_t idx, std::false_type) const;
+    void rehash(size_t capacity);
+
+    Hasher hash_state;
+    int8_t *ctrl;
+    slot_t *slots;
+    size_t cap;
+    size_t len;
+    // Empty slots that may still be filled; reusing a deleted one is free
+    size_t growth_left;
+};
+
+template<typename K, typename V, typename Hasher>
+inline group_hashmap<K, V, Hasher>::group_hashmap(const Hasher &hasher)
+    : hash_state(hasher), ctrl(nullptr), slots(nullptr), cap(0), len(0), growth_left(0)
+{
+}
+
+template<typename K, typename V, typename Hasher>
+inline group_hashmap<K, V, Hasher>::~group_hashmap()
+{
+    clear();
+    free(ctrl);
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto group_hashmap<K, V, Hasher>::insert(K key, value_type value) -> optional_value_type
+{
+    using is_set = std::is_void<V>;
+
+    size_t idx = find(static_cast<lookup_type>(key));
+    if (idx != NOT_FOUND)
+    {
+        optional_value_type old_value = take(idx, is_set{});
+        slots[idx].~slot_t();
+        construct(idx, std::move(key), std::move(value), is_set{});
+        return old_value;
+    }
+
+    if (growth_left == 0)
+    {
+        // Tombstones count against growth, so a table that is mostly
+        // deleted slots is rebuilt at the same size instead of doubled
+        size_t capacity = cap == 0 ? GROUP_SIZE : cap;
+        if (len + 1 > max_used(capacity) / 2)
+            capacity *= 2;
+        rehash(capacity);
+    }
+
+    size_t hash = hash_key(key);
+    idx = find_free(hash);
+    if (ctrl[idx] == group_hashmap_details::EMPTY)
+        growth_left--;
+    ctrl[idx] = h2(hash);
+    construct(idx, std::move(key), std::move(value), is_set{});
+    len++;
+    return {};
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto group_hashmap<K, V, Hasher>::remove(lookup_type key) -> optional_value_type
+{
+    size_t idx = find(key);
+    if (idx == NOT_FOUND)
+        return {};
+
+    optional_value_type old_value = take(idx, std::is_void<V>{});
+    slots[idx].~slot_t();
+    len--;
+
+    // No probe continues past a group with an empty slot, so it's only
+    // the groups that are full that need a tombstone
+    group g(ctrl + (idx & ~(GROUP_SIZE - 1)));
+    if (g.match_empty())
+    {
+        ctrl[idx] = group_hashmap_details::EMPTY;
+        growth_left++;
+    }
+    else
+    {
+        ctrl[idx] = group_hashmap_details::DELETED;
+    }
+    return old_value;
+}
+
+template<typename K, typename V, typename Hasher>
+inline void group_hashmap<K, V, Hasher>::clear()
+{
+    if (cap == 0)
+        return;
+
+    for (size_t i = 0; i < cap && len; ++i)
+    {
+        if (ctrl[i] >= 0)
+        {
+            slots[i].~slot_t();
+            len--;
+        }
+    }
+    memset(ctrl, group_hashmap_details::EMPTY, cap);
+    growth_left = max_used(cap);
+}
+
+template<typename K, typename V, typename Hasher>
+inline void group_hashmap<K, V, Hasher>::shrink()
+{
+    size_t capacity = 0;
+    if (len != 0)
+    {
+        capacity = GROUP_SIZE;
+        while (max_used(capacity) < len)
+            capacity *= 2;
+    }
+    if (capacity != cap)
+        rehash(capacity);
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto group_hashmap<K, V, Hasher>::get(lookup_type key) const -> optional_value_cref
+{
+    size_t idx = find(key);
+    if (idx == NOT_FOUND)
+        return {};
+    return found(idx, std::is_void<V>{});
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto group_hashmap<K, V, Hasher>::get_mut(lookup_type key) const -> optional_value_ref
+{
+    size_t idx = find(key);
+    if (idx == NOT_FOUND)
+        return {};
+    return found(idx, std::is_void<V>{});
+}
+
+template<typename K, typename V, typename Hasher>
+template<typename Q>
+inline size_t group_hashmap<K, V, Hasher>::hash_key(const Q &key) const
+{
+    auto state = hash_state;
+    hash_apply(key, state);
+    return static_cast<size_t>(static_cast<hash_t>(state));
+}
+
+template<typename K, typename V, typename Hasher>
+inline size_t group_hashmap<K, V, Hasher>::find(lookup_type key) const
+{
+    if (len == 0)
+        return NOT_FOUND;
+
+    size_t hash = hash_key(key);
+    int8_t tag = h2(hash);
+    size_t group_mask = cap / GROUP_SIZE - 1;
+    size_t pos = (hash >> 7) & group_mask;
+
+    // Triangular steps visit every group of a power of two table
+    for (size_t step = 1;; ++step)
+    {
+        const int8_t *base = ctrl + pos * GROUP_SIZE;
+        group g(base);
+        for (auto m = g.match(tag); m; m.clear_lowest())
+        {
+            size_t idx = pos * GROUP_SIZE + m.lowest();
+            if (slots[idx].key == key)
+                return idx;
+        }
+        if (g.match_empty())
+            return NOT_FOUND;
+
+        pos = (pos + step) & group_mask;
+    }
+}
+
+template<typename K, typename V, typename Hasher>
+inline size_t group_hashmap<K, V, Hasher>::find_free(size_t hash) const
+{
+    size_t group_mask = cap / GROUP_SIZE - 1;
+    size_t pos = (hash >> 7) & group_mask;
+
+    for (size_t step = 1;; ++step)
+    {
+        auto m = group(ctrl + pos * GROUP_SIZE).match_free();
+        if (m)
+            return pos * GROUP_SIZE + m.lowest();
+
+        pos = (pos + step) & group_mask;
+    }
+}
+
+template<typename K, typename V, typename Hasher>
+inline void group_hashmap<K, V, Hasher>::construct(size_t idx, K &&key, value_type &&, std::true_type)
+{
+    new (&slots[idx]) slot_t{ std::move(key) };
+}
+
+template<typename K, typename V, typename Hasher>
+inline void group_hashmap<K, V, Hasher>::construct(size_t idx, K &&key, value_type &&value, std::false_type)
+{
+    new (&slots[idx]) slot_t{ std::move(key), std::move(value) };
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto group_hashmap<K, V, Hasher>::take(size_t, std::true_type) -> optional_value_type
+{
+    return true;
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto group_hashmap<K, V, Hasher>::take(size_t idx, std::false_type) -> optional_value_type
+{
+    return std::move(slots[idx].value);
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto group_hashmap<K, V, Hasher>::found(size_t, std::true_type) const -> optional_value_ref
+{
+    return true;
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto group_hashmap<K, V, Hasher>::found(size_t idx, std::false_type) const -> optional_value_ref
+{
+    return &slots[idx].value;
+}
+
+template<typename K, typename V, typename Hasher>
+inline void group_hashmap<K, V, Hasher>::rehash(size_t capacity)
+{
+    int8_t *old_ctrl = ctrl;
+    slot_t *old_slots = slots;
+    size_t old_cap = cap;
+
+    ctrl = nullptr;
+    slots = nullptr;
+    cap = capacity;
+    growth_left = max_used(capacity);
+    if (capacity != 0)
+    {
+        // Control bytes first, then the slots; capacity is a multiple of
+        // the group size, which keeps the slots aligned
+        size_t slot_offset = (capacity + alignof(slot_t) - 1) & ~(alignof(slot_t) - 1);
+        ctrl = (int8_t *)malloc(slot_offset + capacity * sizeof(slot_t));
+        if (!ctrl)
+            throw std::bad_alloc();
+        slots = (slot_t *)(ctrl + slot_offset);
+        memset(ctrl, group_hashmap_details::EMPTY, capacity);
+    }
+
+    for (size_t i = 0; i < old_cap; ++i)
+    {
+        if (old_ctrl[i] < 0)
+            continue;
+
+        slot_t &s = old_slots[i];
+        size_t hash = hash_key(s.key);
+        size_t idx = find_free(hash);
+        ctrl[idx] = h2(hash);
+        new (&slots[idx]) slot_t(std::move(s));
+        s.~slot_t();
+        growth_left--;
+    }
+    free(old_ctrl);
+}
@@ -4,7 +4,12 @@
 #include <vector>
 #include <random>
 #include <memory>
-#include <stdint.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+#include <intrin.h>
+#endif
 
 #if defined(__has_include) && __has_include(<gsl.h>)
 #include <gsl.h>
@@ -14,7 +19,7 @@
 #endif
 
 #if defined(__has_include) && __has_include(<string_view>) && \
-    (!defined(_MSC_VER) || (defined(_HAS_CXX17) && _HAS_CXX17 != 0))
+    (defined(_MSC_VER) ? (defined(_HAS_CXX17) && _HAS_CXX17 != 0) : __cplusplus >= 201703L)
 #include <string_view>
 #ifndef STRING_VIEW_INCLUDED
 #define STRING_VIEW_INCLUDED
@@ -44,13 +49,19 @@ namespace HashDetails
 
         inline void write(const uint8_t *data, size_t len)
         {
-            hasher.write(data, data + len);
+            hasher.write(data, len);
         }
 
         inline void write(const void *data, size_t len)
         {
             hasher.write(data, len);
         }
+
+        template <typename Inner = H>
+        inline auto write_int(uint64_t value) -> decltype(std::declval<Inner &>().write_int(value))
+        {
+            hasher.write_int(value);
+        }
 
         #ifdef GSL_INCLUDED
         void write(gsl::span<const uint8_t> data)
@@ -66,6 +77,32 @@ namespace HashDetails
 
         H hasher;
     };
+
+    // Hashers with a write_int take integers whole, the rest get their bytes
+    template <typename H, typename I>
+    inline auto write_int(H &h, I i, int) -> decltype(h.write_int(uint64_t(i)))
+    {
+        h.write_int(uint64_t(i));
+    }
+
+    template <typename H, typename I>
+    inline void write_int(H &h, I i, long)
+    {
+        h.write(&i, sizeof(i));
+    }
+
+    // The word write_int receives for an integer or pointer key
+    template <typename I>
+    inline uint64_t int_word(I i)
+    {
+        return uint64_t(i);
+    }
+
+    template <typename Ptr>
+    inline uint64_t int_word(Ptr *p)
+    {
+        return uint64_t(reinterpret_cast<uintptr_t>(p));
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
@@ -178,6 +215,20 @@ using Fnv1A_32 = Fnv1ADetails::Hasher<uint32_t, 2166136261U, 16777619U>;
 using Fnv1A_64 = Fnv1ADetails::Hasher<uint64_t, 14695981039346656037U, 1099511628211>;
 using Fnv1A = std::conditional<std::is_same<size_t, uint32_t>::value, Fnv1A_32, Fnv1A_64>::type;
 
+// FNV-1A of a string that can be evaluated at compile time, for tables that
+// are generated ahead of time and looked up with the same function. `basis`
+// replaces the offset basis, giving a family of hashes to pick from.
+constexpr uint32_t fnv1a_32(const char *data, size_t len, uint32_t basis = 2166136261U)
+{
+    uint32_t state = basis;
+    for (size_t i = 0; i < len; ++i)
+    {
+        state = state ^ static_cast<uint8_t>(data[i]);
+        state = state * 16777619U;
+    }
+    return state;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////
 // SipHash implementation
 
@@ -398,6 +449,8 @@ namespace SipDetails
     template <typename H, typename Out>
     struct RandomKey
     {
+        using result_type = Out;
+
         RandomKey()
             : hasher(rand_key(), rand_key())
         {
@@ -415,13 +468,19 @@ namespace SipDetails
 
         inline void write(const uint8_t *data, size_t len)
         {
-            hasher.write(data, data + len);
+            hasher.write(data, len);
         }
 
         inline void write(const void *data, size_t len)
         {
             hasher.write(data, len);
         }
+
+        template <typename Inner = H>
+        inline auto write_int(uint64_t value) -> decltype(std::declval<Inner &>().write_int(value))
+        {
+            hasher.write_int(value);
+        }
 
 #ifdef GSL_INCLUDED
         void write(gsl::span<const uint8_t> data)
@@ -455,6 +514,176 @@ using RandomSipHash24_64 = SipDetails::RandomKey<SipHash24_64, uint64_t>;
 using RandomSipHash13 = SipDetails::RandomKey<SipHash13, size_t>;
 using RandomSipHash24 = SipDetails::RandomKey<SipHash24, size_t>;
 
+////////////////////////////////////////////////////////////////////////////////////////////////
+// WyHash-style hasher
+//
+// Every write is folded into the state with one 64x64->128 bit multiply, the
+// construction wyhash uses. Not keyed strongly enough to hold up against
+// chosen inputs; use it for keys the program makes up itself (pointers, ids,
+// cells) and SipHash with a random key for anything read from outside.
+
+namespace WyDetails
+{
+    const uint64_t secret[4] = {
+        0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+        0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull,
+    };
+
+    // Xor of the high and low halves of the full product
+    inline uint64_t folded_multiply(uint64_t a, uint64_t b)
+    {
+#if defined(__SIZEOF_INT128__)
+        __uint128_t r = (__uint128_t)a * b;
+        return uint64_t(r) ^ uint64_t(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        uint64_t hi;
+        uint64_t lo = _umul128(a, b, &hi);
+        return lo ^ hi;
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+        return (a * b) ^ __umulh(a, b);
+#else
+        uint64_t ha = a >> 32, la = uint32_t(a), hb = b >> 32, lb = uint32_t(b);
+        uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+        uint64_t t = rl + (rm0 << 32);
+        uint64_t c = t < rl;
+        uint64_t lo = t + (rm1 << 32);
+        c += lo < t;
+        uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+        return lo ^ hi;
+#endif
+    }
+
+    // Little endian reads; every target we ship on is little endian
+    inline uint64_t read8(const uint8_t *p)
+    {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint64_t read4(const uint8_t *p)
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    struct Hasher64
+    {
+        using result_type = uint64_t;
+
+        Hasher64()
+            : Hasher64(0, 0)
+        {
+        }
+
+        Hasher64(uint64_t k0, uint64_t k1)
+            : seed(k0 ^ folded_multiply(k1 ^ secret[0], secret[1]))
+        {
+            reset();
+        }
+
+        inline void reset()
+        {
+            state = seed ^ secret[0];
+        }
+
+        // Integers and pointers skip the byte handling entirely
+        inline void write_int(uint64_t value)
+        {
+            state = folded_multiply(value ^ secret[1], state ^ secret[2]);
+        }
+
+        inline void write(const uint8_t *data, size_t len)
+        {
+            uint64_t a, b;
+            if (len <= 16)
+            {
+                // Overlapping reads cover 4 to 16 bytes without a loop
+                if (len >= 4)
+                {
+                    size_t mid = (len >> 3) << 2;
+                    a = (read4(data) << 32) | read4(data + mid);
+                    b = (read4(data + len - 4) << 32) | read4(data + len - 4 - mid);
+                }
+                else if (len > 0)
+                {
+                    a = (uint64_t(data[0]) << 16) | (uint64_t(data[len >> 1]) << 8) | data[len - 1];
+                    b = 0;
+                }
+                else
+                {
+                    a = b = 0;
+                }
+            }
+            else
+            {
+                size_t i = len;
+                const uint8_t *p = data;
+                while (i > 16)
+                {
+                    state = folded_multiply(read8(p) ^ secret[1], read8(p + 8) ^ state);
+                    p += 16;
+                    i -= 16;
+                }
+                a = read8(data + len - 16);
+                b = read8(data + len - 8);
+            }
+
+            // The length keeps writes of zero bytes from vanishing
+            state = folded_multiply(a ^ secret[1] ^ len, b ^ state ^ secret[3]);
+        }
+
+        inline void write(const void *data, size_t len)
+        {
+            write(reinterpret_cast<const uint8_t *>(data), len);
+        }
+
+#ifdef GSL_INCLUDED
+        void write(gsl::span<const uint8_t> data)
+        {
+            write(data.data(), data.size());
+        }
+#endif
+
+        operator uint64_t() const
+        {
+            return state;
+        }
+
+        uint64_t seed;
+        uint64_t state;
+    };
+
+    struct Hasher32 : public HashDetails::TruncateHash<Hasher64, uint64_t, uint32_t>
+    {
+        Hasher32() = default;
+        Hasher32(uint64_t k0, uint64_t k1)
+            : HashDetails::TruncateHash<Hasher64, uint64_t, uint32_t>(k0, k1)
+        {
+        }
+    };
+}
+
+using WyHash32 = WyDetails::Hasher32;
+using WyHash64 = WyDetails::Hasher64;
+using WyHash = std::conditional<std::is_same<size_t, uint32_t>::value, WyHash32, WyHash64>::type;
+
+using RandomWyHash64 = SipDetails::RandomKey<WyHash64, uint64_t>;
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Hasher policies, picked per map
+//
+// Fast is for keys the program controls. DosResistant is randomly keyed per
+// map instance, so inputs crafted to collide can't pile up in one bucket
+// chain; use it for anything keyed by data from files, scripts or the network.
+
+namespace HashPolicy
+{
+    using Fast = WyHash64;
+    using DosResistant = RandomSipHash13_64;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////
 // Wrapper to allow use of custom hashers where one would normally expect std::hash
 
@@ -488,42 +717,42 @@ inline uint64_t simple_hash_64(const T &value)
 template <typename H>
 inline void hash_apply(int8_t i, H &h)
 {
-    h.write(&i, sizeof(i));
+    HashDetails::write_int(h, i, 0);
 }
 template <typename H>
 inline void hash_apply(uint8_t i, H &h)
 {
-    h.write(&i, sizeof(i));
+    HashDetails::write_int(h, i, 0);
 }
 template <typename H>
 inline void hash_apply(int16_t i, H &h)
 {
-    h.write(&i, sizeof(i));
+    HashDetails::write_int(h, i, 0);
 }
 template <typename H>
 inline void hash_apply(uint16_t i, H &h)
 {
-    h.write(&i, sizeof(i));
+    HashDetails::write_int(h, i, 0);
 }
 template <typename H>
 inline void hash_apply(int32_t i, H &h)
 {
-    h.write(&i, sizeof(i));
+    HashDetails::write_int(h, i, 0);
 }
 template <typename H>
 inline void hash_apply(uint32_t i, H &h)
 {
-    h.write(&i, sizeof(i));
+    HashDetails::write_int(h, i, 0);
 }
 template <typename H>
 inline void hash_apply(int64_t i, H &h)
 {
-    h.write(&i, sizeof(i));
+    HashDetails::write_int(h, i, 0);
 }
 template <typename H>
 inline void hash_apply(uint64_t i, H &h)
 {
-    h.write(&i, sizeof(i));
+    HashDetails::write_int(h, i, 0);
 }
 template <typename H>
 inline void hash_apply(float i, H &h)
@@ -538,7 +767,7 @@ inline void hash_apply(double i, H &h)
 template <typename H, typename Ptr>
 inline void hash_apply(Ptr *p, H &h)
 {
-    h.write(&p, sizeof(Ptr *));
+    HashDetails::write_int(h, reinterpret_cast<uintptr_t>(p), 0);
 }
 
 namespace std
@@ -561,7 +790,8 @@ namespace std
     template <typename H, typename T, typename D>
     inline void hash_apply(const std::unique_ptr<T, D> &ptr, H &h)
     {
-        hash_apply(ptr.get(), h);
+        // Same hash as the raw pointer, which lives outside std
+        ::hash_apply(ptr.get(), h);
     }
 
     #ifdef STRING_VIEW_INCLUDED
@@ -598,3 +828,55 @@ public:
         return static_cast<size_t>(h);
     }
 };
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Hashing many keys at once
+//
+// Fills out[i] with what hash_apply(keys[i], ...) would give starting from
+// `hasher`'s state. Keys are independent, so their multiplies overlap in
+// the pipeline rather than waiting on each other.
+
+template <typename H, typename K>
+inline void hash_batch(const H &hasher, const K *keys, size_t n, typename H::result_type *out)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        H h = hasher;
+        hash_apply(keys[i], h);
+        out[i] = static_cast<typename H::result_type>(h);
+    }
+}
+
+// WyHash64 over integers and pointers is one multiply per key against a
+// shared operand, done four keys at a time. Neither SSE nor AVX2 has a
+// 64x64->128 bit multiply, and building one from 32-bit products costs
+// more than the scalar multiplies it would replace, so this stays scalar.
+template <typename K>
+inline typename std::enable_if<std::is_integral<K>::value || std::is_pointer<K>::value>::type
+hash_batch(const WyHash64 &hasher, const K *keys, size_t n, uint64_t *out)
+{
+    using WyDetails::folded_multiply;
+    using WyDetails::secret;
+
+    auto word = [](K key) { return HashDetails::int_word(key) ^ secret[1]; };
+    const uint64_t shared = hasher.state ^ secret[2];
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        uint64_t a = word(keys[i]), b = word(keys[i + 1]);
+        uint64_t c = word(keys[i + 2]), d = word(keys[i + 3]);
+        out[i] = folded_multiply(a, shared);
+        out[i + 1] = folded_multiply(b, shared);
+        out[i + 2] = folded_multiply(c, shared);
+        out[i + 3] = folded_multiply(d, shared);
+    }
+    for (; i < n; ++i)
+        out[i] = folded_multiply(word(keys[i]), shared);
+}
+
+template <typename H, typename K>
+inline void hash_batch(const K *keys, size_t n, typename H::result_type *out)
+{
+    hash_batch(H{}, keys, n, out);
+}
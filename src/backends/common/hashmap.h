@@ -1,46 +1,175 @@
 #pragma once
 
 #include "hash.h"
+#include <stddef.h>
 #include <stdlib.h>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || (!defined(_MSVC_LANG) && __cplusplus >= 201703L)
 #include <optional>
-#include <cmath>
+#else
+#include "optional.h"
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#if defined(_M_X64) || defined(_M_IX86)
+#include <xmmintrin.h>
+#elif defined(_M_ARM64)
+#include <intrin.h>
+#endif
+#endif
+
+template <typename K, typename V, typename Hasher>
+class hashmap;
 
 namespace hashmap_details
 {
+    inline void prefetch(const void *p)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(p);
+#elif defined(_M_X64) || defined(_M_IX86)
+        _mm_prefetch(static_cast<const char *>(p), _MM_HINT_T0);
+#elif defined(_M_ARM64)
+        __prefetch(p);
+#else
+        (void)p;
+#endif
+    }
+
     template <typename Hasher, typename K, typename V>
     struct entry
     {
-        entry(K &&key, V &&value, typename Hasher::result_type hash)
-            : key(key), value(value), hash(hash)
+        template <typename ...Args>
+        entry(typename Hasher::result_type hash, K &&key, Args &&...args)
+            : first(std::move(key)), second(std::forward<Args>(args)...), hash(hash)
         {
         }
 
-        V move_value()
+        // Named like std::pair so iterating reads the same as it did over
+        // the std containers. Don't change `first` in place.
+        K first;
+        V second;
+        typename Hasher::result_type hash;
+    };
+
+    template <typename Hasher, typename K>
+    struct entry<Hasher, K, void>
+    {
+        template <typename ...Args>
+        entry(typename Hasher::result_type hash, K &&key, Args &&...)
+            : first(std::move(key)), hash(hash)
         {
-            return std::move(value);
         }
 
-        K key;
-        V value;
+        K first;
         typename Hasher::result_type hash;
     };
 
-    template <typename Hasher, typename K>
-    struct entry<Hasher, K, void>
+    // Maps iterate over their entries, sets over their keys
+    template <typename Entry, typename K, typename V>
+    struct element
+    {
+        using type = Entry;
+        static Entry &get(Entry &e) { return e; }
+        static const Entry &get(const Entry &e) { return e; }
+    };
+
+    template <typename Entry, typename K>
+    struct element<Entry, K, void>
     {
-        template <typename V>
-        entry(K &&key, V &&, typename Hasher::result_type hash)
-            : key(key), hash(hash)
+        using type = const K;
+        static const K &get(const Entry &e) { return e.first; }
+    };
+
+    // Walks the table once around, starting from an empty slot. Backward
+    // shift deletion never moves an entry past an empty slot, so erasing
+    // the current entry only ever pulls later ones back into view.
+    template <typename Entry, typename K, typename V, bool is_const>
+    class iterator
+    {
+        using element_t = element<Entry, K, V>;
+        using entry_t = std::conditional_t<is_const, const Entry, Entry>;
+
+        template <typename E, typename K2, typename V2, bool C>
+        friend class iterator;
+        template <typename K2, typename V2, typename H>
+        friend class ::hashmap;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::remove_const_t<typename element_t::type>;
+        using difference_type = ptrdiff_t;
+        using reference = std::conditional_t<is_const, const typename element_t::type &, typename element_t::type &>;
+        using pointer = std::remove_reference_t<reference> *;
+
+        iterator()
+            : data(nullptr), mask(0), start(0), step(0), cap(0)
         {
         }
 
-        bool move_value()
+        template <bool C = is_const, typename = std::enable_if_t<C>>
+        iterator(const iterator<Entry, K, V, false> &other)
+            : data(other.data), mask(other.mask), start(other.start), step(other.step), cap(other.cap)
         {
-            return true;
         }
 
-        K key;
-        typename Hasher::result_type hash;
+        reference operator*() const
+        {
+            return element_t::get(data[slot()]);
+        }
+        pointer operator->() const
+        {
+            return &**this;
+        }
+        iterator &operator++()
+        {
+            ++step;
+            skip_empty();
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        friend bool operator==(const iterator &l, const iterator &r)
+        {
+            return l.step == r.step;
+        }
+        friend bool operator!=(const iterator &l, const iterator &r)
+        {
+            return l.step != r.step;
+        }
+
+    private:
+        iterator(entry_t *data, size_t cap, size_t start, size_t step)
+            : data(data), mask(cap ? cap - 1 : 0), start(start), step(step), cap(cap)
+        {
+        }
+
+        size_t slot() const
+        {
+            return (start + step) & mask;
+        }
+        void skip_empty()
+        {
+            while (step < cap && data[slot()].hash == 0)
+                ++step;
+        }
+
+        entry_t *data;
+        size_t mask;
+        size_t start;
+        size_t step;
+        size_t cap;
     };
 }
 
@@ -49,25 +178,67 @@ struct hashmap_key_traits;
 template <typename V>
 struct hashmap_value_traits;
 
-template <typename K, typename V, typename Hasher = SipHash13_64>
+// Mean and longest distance of entries from the slot their hash wants
+struct hashmap_probe_stats
+{
+    double mean;
+    size_t longest;
+};
+
+// Robin hood table with backward shift deletion: removing an entry pulls
+// the ones after it back a slot, so there are no tombstones and probe
+// lengths stay where inserts left them however much the map churns. The
+// capacity is a power of two. Home slots come from the top bits of the
+// hash times a Fibonacci constant, so weak hashers (FNV of small integers,
+// aligned pointers) still spread out, and probing steps with a mask.
+//
+// Besides its own insert/remove/get interface it has enough of the
+// std::unordered_map and std::unordered_set interfaces to stand in for
+// them, with one difference: entries move. Inserting invalidates every
+// iterator and reference, and erasing invalidates references to the
+// entries after it. Iterators stay valid across erase(iterator), so
+//
+//     for (auto it = map.begin(); it != map.end();)
+//         it = done(*it) ? map.erase(it) : std::next(it);
+//
+// visits every entry once.
+//
+// Each map is keyed randomly by default (HashPolicy::DosResistant). Maps
+// keyed by the program's own pointers, ids or cells should pass
+// HashPolicy::Fast instead.
+template <typename K, typename V, typename Hasher = HashPolicy::DosResistant>
 class hashmap
 {
     using entry = hashmap_details::entry<Hasher, K, V>;
     using key_traits = hashmap_key_traits<K>;
     using value_traits = hashmap_value_traits<V>;
     using hash_t = typename Hasher::result_type;
-    static constexpr size_t hash_bits = sizeof(hash_t) * 8;
+    using is_set = std::is_void<V>;
+    static const size_t NOT_FOUND = ~size_t(0);
+
+    // Keys other than the lookup type that key_traits lets find() and
+    // friends take without building a K
+    template <typename Q>
+    using if_accepted = std::enable_if_t<key_traits::template accepts<std::decay_t<Q>>::value>;
 
 public:
+    using key_type = K;
     using value_type = typename value_traits::value_type;
     using optional_value_type = typename value_traits::optional_value_type;
     using optional_value_ref = typename value_traits::optional_value_ref;
     using optional_value_cref = typename value_traits::optional_value_cref;
     using lookup_type = typename key_traits::lookup_type;
+    using iterator = hashmap_details::iterator<entry, K, V, false>;
+    using const_iterator = hashmap_details::iterator<entry, K, V, true>;
 
     hashmap(const Hasher &hasher = Hasher{});
+    hashmap(const hashmap &other);
+    hashmap(hashmap &&other) noexcept;
+    hashmap &operator=(const hashmap &other);
+    hashmap &operator=(hashmap &&other) noexcept;
     ~hashmap();
 
+    // Returns the value `key` had before, if any
     optional_value_type insert(K key, value_type value);
     optional_value_type remove(lookup_type key);
     void clear();
@@ -75,67 +246,188 @@ public:
 
     optional_value_cref get(lookup_type key) const;
     optional_value_ref get_mut(lookup_type key) const;
+    template <typename Q, typename = if_accepted<Q>>
+    optional_value_cref get(const Q &key) const;
+    template <typename Q, typename = if_accepted<Q>>
+    optional_value_ref get_mut(const Q &key) const;
+
+    // get() for `count` keys. Hashes a block of keys with hash_batch and
+    // prefetches their home slots before probing any, so the cache misses
+    // of a block overlap instead of coming one after another. On tables
+    // bigger than the cache, ask for a few dozen keys at a time and use the
+    // results before the next call, or the values are evicted again.
+    void get_batch(const K *keys, size_t count, optional_value_cref *out) const;
+    void get_mut_batch(const K *keys, size_t count, optional_value_ref *out) const;
+
+    // O(capacity), for tuning hashers and load
+    hashmap_probe_stats probe_stats() const;
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    size_t size() const;
+    bool empty() const;
+    // Makes room for `count` entries without growing again
+    void reserve(size_t count);
+    void swap(hashmap &other);
+
+    iterator find(lookup_type key);
+    const_iterator find(lookup_type key) const;
+    size_t count(lookup_type key) const;
+    template <typename Q, typename = if_accepted<Q>>
+    iterator find(const Q &key);
+    template <typename Q, typename = if_accepted<Q>>
+    const_iterator find(const Q &key) const;
+    template <typename Q, typename = if_accepted<Q>>
+    size_t count(const Q &key) const;
+
+    // Constructs the value from `args` only if `key` isn't there yet
+    template <typename ...Args>
+    std::pair<iterator, bool> try_emplace(K key, Args &&...args);
+    template <typename ...Args>
+    std::pair<iterator, bool> emplace(K key, Args &&...args);
+    // Maps only; default constructs the value of a new key
+    template <typename U = V, typename = std::enable_if_t<!std::is_void<U>::value>>
+    U &operator[](K key);
+    // Sets only
+    template <typename U = V, typename = std::enable_if_t<std::is_void<U>::value>>
+    std::pair<iterator, bool> insert(K key);
+
+    size_t erase(lookup_type key);
+    template <typename Q, typename = if_accepted<Q>>
+    size_t erase(const Q &key);
+    // Returns the entry after `pos`
+    iterator erase(const_iterator pos);
 
 private:
     template <typename Q>
     hash_t hash_key(const Q &key) const;
-    static bool is_deleted(hash_t hash);
     size_t desired_pos(hash_t hash) const;
     size_t probe_distance(hash_t hash, size_t slot_index) const;
     void alloc();
-    void insert_helper(entry &&entry);
-    std::optional<size_t> lookup_index(lookup_type key) const;
-    void erase(size_t idx);
-    void grow();
+    size_t insert_helper(entry &&entry);
+    template <typename Q>
+    size_t index_of(const Q &key) const;
+    template <typename Q>
+    size_t index_of(const Q &key, hash_t hash) const;
+    template <typename Out>
+    void lookup_batch(const K *keys, size_t count, Out *out) const;
+    void erase_at(size_t idx);
+    void rehash(size_t new_cap);
+    void reserve_one();
+    size_t next_empty(size_t from) const;
+    static size_t capacity_for(size_t count);
+
+    iterator iterator_at(size_t idx);
+    const_iterator iterator_at(size_t idx) const;
+    optional_value_type take_value(size_t idx, std::true_type);
+    optional_value_type take_value(size_t idx, std::false_type);
+    optional_value_ref value_at(size_t idx, std::true_type) const;
+    optional_value_ref value_at(size_t idx, std::false_type) const;
+    void assign_value(size_t idx, value_type &&value, std::true_type);
+    void assign_value(size_t idx, value_type &&value, std::false_type);
 
     Hasher hash_state;
     entry *data;
     size_t cap;
+    size_t mask;
+    size_t shift;
     size_t len;
-    size_t max_probe;
+    // An empty slot, where iteration starts
+    size_t first_empty;
 };
 
 template<typename K, typename V, typename Hasher>
 inline hashmap<K, V, Hasher>::hashmap(const Hasher &hasher)
-    : hash_state(std::move(hasher)), data(nullptr), cap(0), len(0), max_probe(0)
+    : hash_state(hasher), data(nullptr), cap(0), mask(0), shift(0), len(0), first_empty(0)
+{
+}
+
+template<typename K, typename V, typename Hasher>
+inline hashmap<K, V, Hasher>::hashmap(const hashmap &other)
+    : hash_state(other.hash_state), data(nullptr), cap(other.cap), mask(other.mask),
+      shift(other.shift), len(other.len), first_empty(other.first_empty)
+{
+    if (cap == 0)
+        return;
+
+    alloc();
+    for (size_t i = 0; i < cap; ++i)
+    {
+        if (other.data[i].hash != 0)
+            new (&data[i]) entry(other.data[i]);
+    }
+}
+
+template<typename K, typename V, typename Hasher>
+inline hashmap<K, V, Hasher>::hashmap(hashmap &&other) noexcept
+    : hash_state(other.hash_state), data(other.data), cap(other.cap), mask(other.mask),
+      shift(other.shift), len(other.len), first_empty(other.first_empty)
+{
+    other.data = nullptr;
+    other.cap = 0;
+    other.mask = 0;
+    other.shift = 0;
+    other.len = 0;
+    other.first_empty = 0;
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto hashmap<K, V, Hasher>::operator=(const hashmap &other) -> hashmap &
+{
+    if (this != &other)
+    {
+        hashmap copy(other);
+        swap(copy);
+    }
+    return *this;
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto hashmap<K, V, Hasher>::operator=(hashmap &&other) noexcept -> hashmap &
 {
+    hashmap moved(std::move(other));
+    swap(moved);
+    return *this;
 }
 
 template<typename K, typename V, typename Hasher>
 inline hashmap<K, V, Hasher>::~hashmap()
 {
     clear();
-    shrink();
+    free(data);
 }
 
 template<typename K, typename V, typename Hasher>
 inline auto hashmap<K, V, Hasher>::insert(K key, value_type value) -> optional_value_type
 {
-    auto old_value = remove(static_cast<lookup_type>(key));
-
-    if (len >= cap * 0.95)
+    size_t idx = index_of(key);
+    if (idx != NOT_FOUND)
     {
-        grow();
+        optional_value_type old_value = take_value(idx, is_set{});
+        assign_value(idx, std::move(value), is_set{});
+        return old_value;
     }
 
+    reserve_one();
     hash_t hash = hash_key(key);
-    entry e{ std::move(key), std::move(value), std::move(hash) };
-    insert_helper(std::move(e));
-
+    insert_helper(entry{ hash, std::move(key), std::move(value) });
     len++;
 
-    return old_value;
+    return {};
 }
 
 template<typename K, typename V, typename Hasher>
 inline auto hashmap<K, V, Hasher>::remove(lookup_type key) -> optional_value_type
 {
     optional_value_type old_value = {};
-    if (auto old = lookup_index(key))
+    size_t idx = index_of(key);
+    if (idx != NOT_FOUND)
     {
-        entry &e = data[*old];
-        old_value = e.move_value();
-        erase(*old);
+        old_value = take_value(idx, is_set{});
+        erase_at(idx);
     }
     return old_value;
 }
@@ -143,173 +435,382 @@ inline auto hashmap<K, V, Hasher>::remove(lookup_type key) -> optional_value_typ
 template<typename K, typename V, typename Hasher>
 inline void hashmap<K, V, Hasher>::clear()
 {
-    for (int i = 0; i < cap && len; ++i)
+    for (size_t i = 0; i < cap && len; ++i)
     {
         entry &e = data[i];
-        if (e.hash != 0 && !is_deleted(e.hash))
+        if (e.hash != 0)
         {
-            erase(i);
+            e.~entry();
+            e.hash = 0;
+            len--;
         }
     }
+    first_empty = 0;
 }
 
 template<typename K, typename V, typename Hasher>
 inline void hashmap<K, V, Hasher>::shrink()
 {
-    entry *old_data = data;
-    size_t old_cap = cap;
+    size_t new_cap = len == 0 ? 0 : capacity_for(len);
+    if (new_cap != cap)
+    {
+        rehash(new_cap);
+    }
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto hashmap<K, V, Hasher>::get(lookup_type key) const -> optional_value_cref
+{
+    return get_mut(key);
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto hashmap<K, V, Hasher>::get_mut(lookup_type key) const -> optional_value_ref
+{
+    size_t idx = index_of(key);
+    if (idx == NOT_FOUND)
+        return {};
+    return value_at(idx, is_set{});
+}
+
+template<typename K, typename V, typename Hasher>
+template<typename Q, typename>
+inline auto hashmap<K, V, Hasher>::get(const Q &key) const -> optional_value_cref
+{
+    return get_mut(key);
+}
+
+template<typename K, typename V, typename Hasher>
+template<typename Q, typename>
+inline auto hashmap<K, V, Hasher>::get_mut(const Q &key) const -> optional_value_ref
+{
+    size_t idx = index_of(key);
+    if (idx == NOT_FOUND)
+        return {};
+    return value_at(idx, is_set{});
+}
+
+template<typename K, typename V, typename Hasher>
+inline void hashmap<K, V, Hasher>::get_batch(const K *keys, size_t count, optional_value_cref *out) const
+{
+    lookup_batch(keys, count, out);
+}
+
+template<typename K, typename V, typename Hasher>
+inline void hashmap<K, V, Hasher>::get_mut_batch(const K *keys, size_t count, optional_value_ref *out) const
+{
+    lookup_batch(keys, count, out);
+}
+
+template<typename K, typename V, typename Hasher>
+template<typename Out>
+inline void hashmap<K, V, Hasher>::lookup_batch(const K *keys, size_t count, Out *out) const
+{
+    if (len == 0)
+    {
+        std::fill(out, out + count, Out{});
+        return;
+    }
 
-    if (len != 0)
+    // Enough keys in flight to hide memory latency, few enough that the
+    // prefetched lines are still there when they're probed
+    const size_t block = 16;
+    hash_t hashes[block];
+    for (size_t first = 0; first < count; first += block)
     {
-        // Find the next power of two of len
-        cap = len;
-        for (int x : { 1, 2, 4, 8, 16, 32 })
+        size_t n = std::min(block, count - first);
+        hash_batch(hash_state, keys + first, n, hashes);
+        for (size_t i = 0; i < n; ++i)
         {
-            cap |= cap >> x;
+            if (hashes[i] == 0) hashes[i] = 1;
+            hashmap_details::prefetch(&data[desired_pos(hashes[i])]);
         }
-        cap++;
-
-        alloc();
-        max_probe = 0;
-
-        for (size_t i = 0; i < old_cap; ++i)
+        for (size_t i = 0; i < n; ++i)
         {
-            if (old_data[i].hash != 0 && !is_deleted(old_data[i].hash))
-            {
-                insert_helper(std::move(old_data[i]));
-            }
+            size_t idx = index_of(keys[first + i], hashes[i]);
+            out[first + i] = idx == NOT_FOUND ? Out{} : Out(value_at(idx, is_set{}));
         }
     }
-    else
-    {
-        data = nullptr;
-        cap = 0;
-    }
+}
 
-    for (size_t i = 0; i < old_cap; ++i)
+template<typename K, typename V, typename Hasher>
+inline hashmap_probe_stats hashmap<K, V, Hasher>::probe_stats() const
+{
+    hashmap_probe_stats stats{ 0, 0 };
+    size_t total = 0;
+    for (size_t i = 0; i < cap; ++i)
     {
-        if (old_data[i].hash != 0)
+        if (data[i].hash != 0)
         {
-            old_data[i].~entry();
+            size_t dist = probe_distance(data[i].hash, i);
+            total += dist;
+            stats.longest = std::max(stats.longest, dist);
         }
     }
-    free(old_data);
+    stats.mean = len ? double(total) / double(len) : 0;
+    return stats;
 }
 
 template<typename K, typename V, typename Hasher>
-inline auto hashmap<K, V, Hasher>::get(lookup_type key) const -> optional_value_cref
+inline auto hashmap<K, V, Hasher>::begin() -> iterator
+{
+    iterator it(data, cap, first_empty, 0);
+    it.skip_empty();
+    return it;
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto hashmap<K, V, Hasher>::end() -> iterator
+{
+    return iterator(data, cap, first_empty, cap);
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto hashmap<K, V, Hasher>::begin() const -> const_iterator
+{
+    const_iterator it(data, cap, first_empty, 0);
+    it.skip_empty();
+    return it;
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto hashmap<K, V, Hasher>::end() const -> const_iterator
 {
-    if (auto idx = lookup_index(key))
+    return const_iterator(data, cap, first_empty, cap);
+}
+
+template<typename K, typename V, typename Hasher>
+inline size_t hashmap<K, V, Hasher>::size() const
+{
+    return len;
+}
+
+template<typename K, typename V, typename Hasher>
+inline bool hashmap<K, V, Hasher>::empty() const
+{
+    return len == 0;
+}
+
+template<typename K, typename V, typename Hasher>
+inline void hashmap<K, V, Hasher>::reserve(size_t count)
+{
+    size_t new_cap = capacity_for(count);
+    if (new_cap > cap)
     {
-        if constexpr(std::is_same<V, void>::value)
-            return true;
-        else
-            return data[idx].value;
+        rehash(new_cap);
     }
-    return{};
 }
 
 template<typename K, typename V, typename Hasher>
-inline auto hashmap<K, V, Hasher>::get_mut(lookup_type key) const -> optional_value_ref
+inline void hashmap<K, V, Hasher>::swap(hashmap &other)
 {
-    if (auto idx = lookup_index(key))
+    std::swap(hash_state, other.hash_state);
+    std::swap(data, other.data);
+    std::swap(cap, other.cap);
+    std::swap(mask, other.mask);
+    std::swap(shift, other.shift);
+    std::swap(len, other.len);
+    std::swap(first_empty, other.first_empty);
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto hashmap<K, V, Hasher>::find(lookup_type key) -> iterator
+{
+    size_t idx = index_of(key);
+    return idx == NOT_FOUND ? end() : iterator_at(idx);
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto hashmap<K, V, Hasher>::find(lookup_type key) const -> const_iterator
+{
+    size_t idx = index_of(key);
+    return idx == NOT_FOUND ? end() : iterator_at(idx);
+}
+
+template<typename K, typename V, typename Hasher>
+inline size_t hashmap<K, V, Hasher>::count(lookup_type key) const
+{
+    return index_of(key) != NOT_FOUND;
+}
+
+template<typename K, typename V, typename Hasher>
+template<typename Q, typename>
+inline auto hashmap<K, V, Hasher>::find(const Q &key) -> iterator
+{
+    size_t idx = index_of(key);
+    return idx == NOT_FOUND ? end() : iterator_at(idx);
+}
+
+template<typename K, typename V, typename Hasher>
+template<typename Q, typename>
+inline auto hashmap<K, V, Hasher>::find(const Q &key) const -> const_iterator
+{
+    size_t idx = index_of(key);
+    return idx == NOT_FOUND ? end() : iterator_at(idx);
+}
+
+template<typename K, typename V, typename Hasher>
+template<typename Q, typename>
+inline size_t hashmap<K, V, Hasher>::count(const Q &key) const
+{
+    return index_of(key) != NOT_FOUND;
+}
+
+template<typename K, typename V, typename Hasher>
+template<typename ...Args>
+inline auto hashmap<K, V, Hasher>::try_emplace(K key, Args &&...args) -> std::pair<iterator, bool>
+{
+    size_t idx = index_of(key);
+    if (idx != NOT_FOUND)
     {
-        if constexpr(std::is_same<V, void>::value)
-            return true;
-        else
-            return data[idx].value;
+        return { iterator_at(idx), false };
     }
-    return{};
+
+    reserve_one();
+    hash_t hash = hash_key(key);
+    idx = insert_helper(entry{ hash, std::move(key), std::forward<Args>(args)... });
+    len++;
+
+    return { iterator_at(idx), true };
+}
+
+template<typename K, typename V, typename Hasher>
+template<typename ...Args>
+inline auto hashmap<K, V, Hasher>::emplace(K key, Args &&...args) -> std::pair<iterator, bool>
+{
+    return try_emplace(std::move(key), std::forward<Args>(args)...);
+}
+
+template<typename K, typename V, typename Hasher>
+template<typename U, typename>
+inline U &hashmap<K, V, Hasher>::operator[](K key)
+{
+    return try_emplace(std::move(key)).first->second;
+}
+
+template<typename K, typename V, typename Hasher>
+template<typename U, typename>
+inline auto hashmap<K, V, Hasher>::insert(K key) -> std::pair<iterator, bool>
+{
+    return try_emplace(std::move(key));
+}
+
+template<typename K, typename V, typename Hasher>
+inline size_t hashmap<K, V, Hasher>::erase(lookup_type key)
+{
+    size_t idx = index_of(key);
+    if (idx == NOT_FOUND)
+        return 0;
+
+    erase_at(idx);
+    return 1;
+}
+
+template<typename K, typename V, typename Hasher>
+template<typename Q, typename>
+inline size_t hashmap<K, V, Hasher>::erase(const Q &key)
+{
+    size_t idx = index_of(key);
+    if (idx == NOT_FOUND)
+        return 0;
+
+    erase_at(idx);
+    return 1;
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto hashmap<K, V, Hasher>::erase(const_iterator pos) -> iterator
+{
+    erase_at(pos.slot());
+
+    // The next entry may have been shifted into the erased slot
+    iterator next(data, cap, pos.start, pos.step);
+    next.skip_empty();
+    return next;
 }
 
 template<typename K, typename V, typename Hasher>
 template<typename Q>
 inline auto hashmap<K, V, Hasher>::hash_key(const Q &key) const -> hash_t
 {
-    constexpr hash_t mask = ~hash_t(0) ^ (hash_t(1) << (hash_bits - 1));
     auto state = hash_state;
     hash_apply(key, state);
     auto hash = static_cast<hash_t>(state);
+    // 0 marks an empty slot
     if (hash == 0) hash = 1;
-    return hash & mask;
-}
-
-template<typename K, typename V, typename Hasher>
-inline bool hashmap<K, V, Hasher>::is_deleted(hash_t hash)
-{
-    return (hash >> (hash_bits - 1)) != 0;
+    return hash;
 }
 
 template<typename K, typename V, typename Hasher>
 inline size_t hashmap<K, V, Hasher>::desired_pos(hash_t hash) const
 {
-    constexpr hash_t mask = ~hash_t(0) ^ (hash_t(1) << (hash_bits - 1));
-    return (hash & mask) % cap;
+    return size_t((uint64_t(hash) * 0x9E3779B97F4A7C15ull) >> shift);
 }
 
 template<typename K, typename V, typename Hasher>
 inline size_t hashmap<K, V, Hasher>::probe_distance(hash_t hash, size_t slot_index) const
 {
-    return (slot_index + cap - desired_pos(hash)) % cap;
+    return (slot_index - desired_pos(hash)) & mask;
 }
 
 template<typename K, typename V, typename Hasher>
 inline void hashmap<K, V, Hasher>::alloc()
 {
     data = (entry *)calloc(cap, sizeof(entry));
+    if (!data)
+        throw std::bad_alloc();
 }
 
 template<typename K, typename V, typename Hasher>
-inline void hashmap<K, V, Hasher>::insert_helper(entry &&insert_entry)
+inline size_t hashmap<K, V, Hasher>::insert_helper(entry &&insert_entry)
 {
     size_t pos = desired_pos(insert_entry.hash);
     size_t dist = 0;
+    // Where the entry passed in ends up; later swaps carry others along
+    size_t placed = NOT_FOUND;
 
     for (;;)
     {
         entry &e = data[pos];
-        
+
         if (e.hash == 0)
         {
             new (&e) entry(std::move(insert_entry));
-            return;
+            if (pos == first_empty)
+                first_empty = next_empty(pos);
+            return placed == NOT_FOUND ? pos : placed;
         }
 
         size_t e_probe_dist = probe_distance(e.hash, pos);
         if (e_probe_dist < dist)
         {
-            if (is_deleted(e.hash))
-            {
-                e.~entry();
-                new (&e) entry(std::move(insert_entry));
-                return;
-            }
-
             std::swap(e, insert_entry);
             dist = e_probe_dist;
+            if (placed == NOT_FOUND)
+                placed = pos;
         }
 
-        pos = (pos + 1) % cap;
+        pos = (pos + 1) & mask;
         dist++;
-
-        if (dist > max_probe)
-        {
-            max_probe = dist;
-        }
     }
 }
 
 template<typename K, typename V, typename Hasher>
-inline std::optional<size_t> hashmap<K, V, Hasher>::lookup_index(lookup_type key) const
+template<typename Q>
+inline size_t hashmap<K, V, Hasher>::index_of(const Q &key) const
 {
-    constexpr size_t TOMB_MASK = size_t(1) << (hash_bits - 1);
-
     if (len == 0)
     {
-        return std::nullopt;
+        return NOT_FOUND;
     }
 
-    hash_t hash = hash_key(key);
+    return index_of(key, hash_key(key));
+}
+
+template<typename K, typename V, typename Hasher>
+template<typename Q>
+inline size_t hashmap<K, V, Hasher>::index_of(const Q &key, hash_t hash) const
+{
     size_t pos = desired_pos(hash);
     size_t dist = 0;
 
@@ -317,51 +818,67 @@ inline std::optional<size_t> hashmap<K, V, Hasher>::lookup_index(lookup_type key
     {
         entry &e = data[pos];
 
+        // A richer entry than we'd be means the key would have taken its slot
         if (e.hash == 0 || dist > probe_distance(e.hash, pos))
         {
-            return std::nullopt;
+            return NOT_FOUND;
         }
-        else if (e.hash == hash && e.key == key)
+        else if (e.hash == hash && key_traits::equal(e.first, key))
         {
             return pos;
         }
         else
         {
-            pos = (pos + 1) % cap;
+            pos = (pos + 1) & mask;
             dist++;
         }
     }
 }
 
 template<typename K, typename V, typename Hasher>
-inline void hashmap<K, V, Hasher>::erase(size_t idx)
+inline void hashmap<K, V, Hasher>::erase_at(size_t idx)
 {
-    constexpr size_t MASK = size_t(1) << (hash_bits - 1);
-    entry &e = data[idx];
-    { entry temp = std::move(e); }
-    e.hash |= MASK;
+    data[idx].~entry();
+
+    // Shift the run after the hole back until an entry that is already
+    // home, or an empty slot
+    size_t hole = idx;
+    size_t next = (idx + 1) & mask;
+    while (data[next].hash != 0 && probe_distance(data[next].hash, next) != 0)
+    {
+        new (&data[hole]) entry(std::move(data[next]));
+        data[next].~entry();
+        hole = next;
+        next = (next + 1) & mask;
+    }
+    data[hole].hash = 0;
     len--;
 }
 
 template<typename K, typename V, typename Hasher>
-inline void hashmap<K, V, Hasher>::grow()
+inline void hashmap<K, V, Hasher>::rehash(size_t new_cap)
 {
     entry *old_data = data;
     size_t old_cap = cap;
 
-    cap = cap == 0 ? 16 : cap * 2;
-    alloc();
-    max_probe = 0;
+    cap = new_cap;
+    mask = new_cap == 0 ? 0 : new_cap - 1;
+    shift = 64;
+    for (size_t c = new_cap; c > 1; c >>= 1)
+        shift--;
+    first_empty = 0;
+    data = nullptr;
+    if (new_cap != 0)
+    {
+        alloc();
+    }
 
-    for (int i = 0; i < old_cap; ++i)
+    for (size_t i = 0; i < old_cap; ++i)
     {
         entry &e = old_data[i];
-        if (e.hash != 0 && !is_deleted(e.hash))
-        {
-            insert_helper(std::move(e));
-        }
         if (e.hash != 0)
         {
+            insert_helper(std::move(e));
             e.~entry();
         }
     }
@@ -369,11 +886,100 @@ inline void hashmap<K, V, Hasher>::grow()
     free(old_data);
 }
 
+template<typename K, typename V, typename Hasher>
+inline void hashmap<K, V, Hasher>::reserve_one()
+{
+    // Grow at 15/16 full, which also keeps an empty slot to start
+    // iterating from
+    if (len + 1 > cap - cap / 16)
+    {
+        rehash(cap == 0 ? 16 : cap * 2);
+    }
+}
+
+template<typename K, typename V, typename Hasher>
+inline size_t hashmap<K, V, Hasher>::next_empty(size_t from) const
+{
+    size_t pos = (from + 1) & mask;
+    while (data[pos].hash != 0)
+        pos = (pos + 1) & mask;
+    return pos;
+}
+
+template<typename K, typename V, typename Hasher>
+inline size_t hashmap<K, V, Hasher>::capacity_for(size_t count)
+{
+    size_t new_cap = 16;
+    while (count > new_cap - new_cap / 16)
+    {
+        new_cap *= 2;
+    }
+    return new_cap;
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto hashmap<K, V, Hasher>::iterator_at(size_t idx) -> iterator
+{
+    return iterator(data, cap, first_empty, (idx - first_empty) & mask);
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto hashmap<K, V, Hasher>::iterator_at(size_t idx) const -> const_iterator
+{
+    return const_iterator(data, cap, first_empty, (idx - first_empty) & mask);
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto hashmap<K, V, Hasher>::take_value(size_t, std::true_type) -> optional_value_type
+{
+    return true;
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto hashmap<K, V, Hasher>::take_value(size_t idx, std::false_type) -> optional_value_type
+{
+    return optional_value_type(std::move(data[idx].second));
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto hashmap<K, V, Hasher>::value_at(size_t, std::true_type) const -> optional_value_ref
+{
+    return true;
+}
+
+template<typename K, typename V, typename Hasher>
+inline auto hashmap<K, V, Hasher>::value_at(size_t idx, std::false_type) const -> optional_value_ref
+{
+    return &data[idx].second;
+}
+
+template<typename K, typename V, typename Hasher>
+inline void hashmap<K, V, Hasher>::assign_value(size_t, value_type &&, std::true_type)
+{
+}
+
+template<typename K, typename V, typename Hasher>
+inline void hashmap<K, V, Hasher>::assign_value(size_t idx, value_type &&value, std::false_type)
+{
+    data[idx].second = std::move(value);
+}
+
 template <typename K>
 struct hashmap_key_traits
 {
     // The lookup type must have identical Hash behavior to K
     using lookup_type = const K &;
+
+    // Other types a key may be looked up by, which must hash exactly like
+    // the key they're equal to. Specialize the traits to add some.
+    template <typename Q>
+    struct accepts : std::false_type {};
+
+    template <typename Q>
+    static bool equal(const K &key, const Q &other)
+    {
+        return key == other;
+    }
 };
 
 #ifdef STRING_VIEW_INCLUDED
@@ -381,16 +987,63 @@ template <typename Elem, typename Traits, typename Alloc>
 struct hashmap_key_traits<std::basic_string<Elem, Traits, Alloc>>
 {
     using lookup_type = const std::basic_string_view<Elem, Traits> &;
+
+    template <typename Q>
+    struct accepts : std::false_type {};
+
+    template <typename Q>
+    static bool equal(const std::basic_string<Elem, Traits, Alloc> &key, const Q &other)
+    {
+        return key == other;
+    }
 };
 #endif
 
+// Owning pointers can be looked up by the raw pointer, which hashes the same
+template <typename T, typename D>
+struct hashmap_key_traits<std::unique_ptr<T, D>>
+{
+    using lookup_type = const std::unique_ptr<T, D> &;
+
+    template <typename Q>
+    struct accepts : std::integral_constant<bool, std::is_same<Q, T *>::value || std::is_same<Q, const T *>::value> {};
+
+    static bool equal(const std::unique_ptr<T, D> &key, const std::unique_ptr<T, D> &other)
+    {
+        return key == other;
+    }
+    static bool equal(const std::unique_ptr<T, D> &key, const T *other)
+    {
+        return key.get() == other;
+    }
+};
+
+template <typename T>
+struct hashmap_key_traits<std::shared_ptr<T>>
+{
+    using lookup_type = const std::shared_ptr<T> &;
+
+    template <typename Q>
+    struct accepts : std::integral_constant<bool, std::is_same<Q, T *>::value || std::is_same<Q, const T *>::value> {};
+
+    static bool equal(const std::shared_ptr<T> &key, const std::shared_ptr<T> &other)
+    {
+        return key == other;
+    }
+    static bool equal(const std::shared_ptr<T> &key, const T *other)
+    {
+        return key.get() == other;
+    }
+};
+
 template <typename V>
 struct hashmap_value_traits
 {
     using value_type = V;
     using optional_value_type = std::optional<value_type>;
-    using optional_value_ref = std::optional<value_type &>;
-    using optional_value_cref = std::optional<const value_type &>;
+    // There's no optional reference, null stands for a missing key
+    using optional_value_ref = value_type *;
+    using optional_value_cref = const value_type *;
 };
 
 template <>
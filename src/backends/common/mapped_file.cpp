@@ -0,0 +1,125 @@
+#include "pch.h"
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+mapped_file::mapped_file()
+    : view(nullptr), len(0), file_id{ 0, 0 }, file_handle(nullptr), map_handle(nullptr)
+{
+}
+
+mapped_file::~mapped_file()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool mapped_file::open(const char *path)
+{
+    close();
+
+    HANDLE file = CreateFileA(
+        path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    BY_HANDLE_FILE_INFORMATION info;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0 ||
+        !GetFileInformationByHandle(file, &info))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void *ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!ptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    view = (const uint8_t *)ptr;
+    len = (size_t)file_size.QuadPart;
+    file_id.volume = info.dwVolumeSerialNumber;
+    file_id.index = (uint64_t(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    file_handle = file;
+    map_handle = mapping;
+    return true;
+}
+
+void mapped_file::close()
+{
+    if (view)
+        UnmapViewOfFile(view);
+    if (map_handle)
+        CloseHandle((HANDLE)map_handle);
+    if (file_handle)
+        CloseHandle((HANDLE)file_handle);
+
+    view = nullptr;
+    len = 0;
+    file_id = identity{ 0, 0 };
+    file_handle = nullptr;
+    map_handle = nullptr;
+}
+
+#else
+
+bool mapped_file::open(const char *path)
+{
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void *ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+    if (ptr == MAP_FAILED)
+        return false;
+
+    view = (const uint8_t *)ptr;
+    len = (size_t)st.st_size;
+    file_id.volume = (uint64_t)st.st_dev;
+    file_id.index = (uint64_t)st.st_ino;
+    return true;
+}
+
+void mapped_file::close()
+{
+    if (view)
+        munmap((void *)view, len);
+
+    view = nullptr;
+    len = 0;
+    file_id = identity{ 0, 0 };
+}
+
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Read-only memory mapping of a whole file. The mapping stays valid for
+// the lifetime of the object, so anything that borrows pointers into it
+// has to keep the mapped_file alive (scene_graph holds them in shared_ptrs).
+class mapped_file
+{
+public:
+    // Tells files apart regardless of the path they were opened through
+    struct identity
+    {
+        uint64_t volume;
+        uint64_t index;
+
+        bool operator==(const identity &o) const { return volume == o.volume && index == o.index; }
+    };
+
+    mapped_file();
+    mapped_file(const mapped_file &) = delete;
+    mapped_file &operator=(const mapped_file &) = delete;
+    ~mapped_file();
+
+    bool open(const char *path);
+    void close();
+
+    const uint8_t *data() const { return view; }
+    size_t size() const { return len; }
+    const identity &id() const { return file_id; }
+
+private:
+    const uint8_t *view;
+    size_t len;
+    identity file_id;
+    void *file_handle;
+    void *map_handle;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Records items from any number of threads, each into its own queue.
+//
+// A push only takes the pushing thread's own lock, which is uncontended
+// except for the moment the queue is drained, so workers editing different
+// parts of a scene never wait on each other. Draining is done by one thread
+// at a time, usually the one drawing.
+template <typename T>
+class mutation_queues
+{
+public:
+    mutation_queues() : id(next_id()) {}
+
+    mutation_queues(const mutation_queues &) = delete;
+    mutation_queues &operator=(const mutation_queues &) = delete;
+
+    void push(const T &item)
+    {
+        shard &s = local();
+        std::lock_guard<std::mutex> guard(s.lock);
+        s.items.push_back(item);
+    }
+    void push(const T *items, size_t count)
+    {
+        shard &s = local();
+        std::lock_guard<std::mutex> guard(s.lock);
+        s.items.insert(s.items.end(), items, items + count);
+    }
+
+    // Appends everything queued so far to `out`. Items from one thread keep
+    // their order, threads follow each other in the order they first pushed.
+    void drain_into(std::vector<T> &out)
+    {
+        {
+            std::lock_guard<std::mutex> guard(registry_lock);
+            draining.clear();
+            for (auto &s : shards)
+                draining.push_back(s.get());
+        }
+
+        for (shard *s : draining)
+        {
+            std::lock_guard<std::mutex> guard(s->lock);
+            out.insert(out.end(), s->items.begin(), s->items.end());
+            s->items.clear();
+        }
+    }
+
+private:
+    struct shard
+    {
+        std::thread::id owner;
+        std::mutex lock;
+        std::vector<T> items;
+    };
+
+    shard &local()
+    {
+        // A single cached entry per thread covers the usual one-scene case
+        struct cache_entry
+        {
+            uint64_t id;
+            shard *s;
+        };
+        static thread_local cache_entry cache = { 0, nullptr };
+        if (cache.id == id)
+            return *cache.s;
+
+        auto self = std::this_thread::get_id();
+        std::lock_guard<std::mutex> guard(registry_lock);
+
+        shard *found = nullptr;
+        for (auto &s : shards)
+        {
+            if (s->owner == self)
+            {
+                found = s.get();
+                break;
+            }
+        }
+        if (!found)
+        {
+            shards.emplace_back(new shard);
+            found = shards.back().get();
+            found->owner = self;
+        }
+
+        cache = { id, found };
+        return *found;
+    }
+
+    // Ids are never reused, so a thread's cache can't point into a queue
+    // that was freed and reallocated at the same address
+    static uint64_t next_id()
+    {
+        static std::atomic<uint64_t> counter{ 0 };
+        return ++counter;
+    }
+
+    uint64_t id;
+    std::mutex registry_lock;
+    std::vector<std::unique_ptr<shard>> shards;
+    std::vector<shard *> draining;
+};
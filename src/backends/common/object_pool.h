@@ -1,6 +1,9 @@
 #pragma once
 
+#include "virtual_memory.h"
 #include <stdint.h>
+#include <string.h>
+#include <algorithm>
 #include <type_traits>
 #include <memory>
 #include <vector>
@@ -11,6 +14,9 @@ class object_pool;
 struct pool_allocation
 {
     void *memory;
+    // Generational handle naming this allocation, see object_pool::resolve.
+    // 0 is never a valid handle.
+    uint32_t handle;
 
 private:
     void *_reserved;
@@ -18,22 +24,92 @@ private:
     friend class object_pool;
 };
 
+// What a pool holds, for sizing pools and spotting leaks
+struct pool_usage
+{
+    uint32_t live;
+    uint32_t buckets;
+    uint64_t reserved_bytes;
+    uint64_t committed_bytes;
+    // Cells handed to the pool's free lists, waiting for an object
+    uint32_t free_cells;
+    // Since the pool was created
+    uint64_t allocs;
+    uint64_t frees;
+};
+
 template <size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
 class object_pool
 {
 public:
     using allocation = ::pool_allocation;
 
+    // Handles keep a slot index (plus one) in their low 24 bits and the
+    // slot's generation in the high 8. Freeing bumps the generation so old
+    // handles stop resolving, and freed slots are reused oldest first so a
+    // generation takes as long as possible to come around again.
+    static const uint32_t HANDLE_SLOT_BITS = 24;
+    static const uint32_t HANDLE_SLOT_MASK = (1u << HANDLE_SLOT_BITS) - 1;
+    static const uint32_t MAX_HANDLES = HANDLE_SLOT_MASK;
+
+    // Fails (with null memory) once MAX_HANDLES objects are alive
     auto alloc() -> allocation;
+    // Only the handle of `alloc` is used, so a copy made before the object
+    // was moved by compact() still frees it
     auto free(const allocation &alloc) -> void;
+
+    // Allocates `count` objects into `out`, carving runs of adjacent cells
+    // out of a bucket's untouched tail where there's room, so objects made
+    // together sit together. Returns how many were allocated, which is
+    // fewer than `count` only once the pool is out of handles.
+    auto alloc_n(uint32_t count, allocation *out) -> uint32_t;
+    auto free_n(const allocation *allocs, uint32_t count) -> void;
+    // Releases buckets that have no objects left, but one, so a pool that
+    // hovers around a bucket boundary doesn't map and unmap it over and over
     auto collect() -> void;
 
+    // Moves up to `max_moves` objects out of the highest addressed buckets
+    // into holes in the lowest addressed ones, then releases the buckets
+    // that were emptied. Objects are moved with memcpy, after which
+    // `on_move(const allocation &)` gets the new allocation so the owner
+    // can fix up pointers to it. Handles keep resolving. Returns how many
+    // objects moved; 0 once nothing is left to gain, which is also the
+    // case until the holes add up to a whole bucket. Cheap to call every
+    // frame: that check is O(buckets) and nothing else runs if it fails.
+    template <typename relocate>
+    auto compact(uint32_t max_moves, relocate &&on_move) -> uint32_t;
+
+    // The object `handle` names, or null if it was freed. O(1).
+    auto resolve(uint32_t handle) const -> void *;
+
+    // O(buckets)
+    auto usage() const -> pool_usage;
+
 private:
     static const uint32_t FREE_END = ~((uint32_t)0);
+    static const uint32_t SLOTS_PER_CHUNK = 4096;
+
+    struct bucket_t;
+    struct handle_slot
+    {
+        void *memory;
+        bucket_t *bucket;
+        uint32_t generation;
+        uint32_t next_free;
+    };
+    auto slot_at(uint32_t slot) const -> handle_slot &
+    {
+        return ((handle_slot *)slot_chunks[slot / SLOTS_PER_CHUNK]->data())[slot % SLOTS_PER_CHUNK];
+    }
     using obj_storage = std::aligned_storage_t<(obj_size < 4 ? 4 : obj_size), (obj_align < 4 ? 4 : obj_align)>;
+    // A bucket only reserves its address space up front. Pages are
+    // committed as the bump pointer reaches them, so a pool holding a
+    // handful of objects costs a page rather than the whole bucket.
     struct bucket_t
     {
-        obj_storage objects[objects_per_bucket];
+        reserved_region storage;
+        // Slot (plus one) of the object in each cell, 0 while it's free
+        reserved_region owners;
         uint32_t free_head = FREE_END;
         uint32_t end = 0;
         uint32_t remaining = objects_per_bucket;
@@ -43,100 +119,372 @@ private:
             uint32_t next;
         };
 
+        bool reserve()
+        {
+            return storage.reserve(size_t(objects_per_bucket) * sizeof(obj_storage)) &&
+                   owners.reserve(size_t(objects_per_bucket) * sizeof(uint32_t));
+        }
+        bool commit(uint32_t cells)
+        {
+            return storage.commit(size_t(cells) * sizeof(obj_storage)) &&
+                   owners.commit(size_t(cells) * sizeof(uint32_t));
+        }
+        obj_storage *objects()
+        {
+            return (obj_storage *)storage.data();
+        }
+        uint32_t *owner()
+        {
+            return (uint32_t *)owners.data();
+        }
+        // Takes a free cell, the bump pointer's only once the free list is
+        // empty. The caller commits up to end + 1 beforehand.
+        uint32_t take_cell()
+        {
+            remaining--;
+            if (free_head == FREE_END)
+                return end++;
+
+            uint32_t cell = free_head;
+            free_head = head()->next;
+            return cell;
+        }
+        void release_cell(uint32_t cell)
+        {
+            owner()[cell] = 0;
+            remaining++;
+            if (cell + 1 == end)
+            {
+                end--;
+                return;
+            }
+
+            auto node = (free_node *)&objects()[cell];
+            node->next = free_head;
+            free_head = cell;
+        }
         free_node *head()
         {
             if (free_head == FREE_END)
                 return nullptr;
-            return (free_node *)&objects[free_head];
+            return (free_node *)&objects()[free_head];
         }
     };
 
+    // Lists the buckets with room, the lowest addressed last so it's used first
+    void sort_free_buckets();
+    // How many of `count` handles can be given out, with the slot table
+    // committed for them
+    auto reserve_slots(uint32_t count) -> uint32_t;
+    auto take_slot() -> uint32_t;
+    auto assign(bucket_t &bucket, uint32_t cell) -> allocation;
+
     std::vector<std::unique_ptr<bucket_t>> buckets;
     std::vector<bucket_t *> free_buckets;
+
+    // The slot table, in chunks that are each reserved once the one before
+    // is full and committed as their slots are first used. Chunks never
+    // move, and a pool only reserves room for the handles it has handed out.
+    std::vector<std::unique_ptr<reserved_region>> slot_chunks;
+    uint32_t slot_count = 0;
+    uint32_t free_slot_count = 0;
+    uint32_t free_slot_head = FREE_END;
+    uint32_t free_slot_tail = FREE_END;
+
+    uint64_t alloc_count = 0;
+    uint64_t free_count = 0;
 };
 
-// Default to 4MB allocations
+// Default to 4MB buckets, most of which stays uncommitted in small pools
 template <typename T>
 using object_pool_t = object_pool<sizeof(T), alignof(T), 4 * 1024 * 1024 / sizeof(T)>;
 
 template<size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
 inline auto object_pool<obj_size, obj_align, objects_per_bucket>::alloc() -> allocation
 {
+    allocation none;
+    none.memory = nullptr;
+    none.handle = 0;
+    none._reserved = nullptr;
+
+    // Everything that can fail happens before any state changes
+    if (reserve_slots(1) == 0)
+        return none;
+
     if (free_buckets.empty())
     {
         std::unique_ptr<bucket_t> new_bucket{ new bucket_t };
+        if (!new_bucket->reserve())
+            return none;
         free_buckets.push_back(new_bucket.get());
         buckets.push_back(std::move(new_bucket));
     }
 
     auto &bucket = *free_buckets.back();
+    if (bucket.free_head == FREE_END && !bucket.commit(bucket.end + 1))
+        return none;
     if (bucket.remaining == 1)
         free_buckets.pop_back();
 
-    allocation alloc;
-    if (bucket.free_head != FREE_END)
+    return assign(bucket, bucket.take_cell());
+}
+
+template<size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline auto object_pool<obj_size, obj_align, objects_per_bucket>::alloc_n(uint32_t count, allocation *out) -> uint32_t
+{
+    uint32_t done = 0;
+    while (done < count)
     {
-        auto *head = bucket.head();
-        bucket.free_head = head->next;
-        alloc.memory = head;
-        alloc._reserved = &bucket;
+        // Without a bump region to carve from, one at a time fills holes
+        // or starts a new bucket that the next run can use
+        bucket_t *bucket = free_buckets.empty() ? nullptr : free_buckets.back();
+        uint32_t room = bucket ? objects_per_bucket - bucket->end : 0;
+        if (room == 0)
+        {
+            out[done] = alloc();
+            if (!out[done].memory)
+                break;
+            ++done;
+            continue;
+        }
+
+        uint32_t run = reserve_slots(std::min(count - done, room));
+        if (run == 0 || !bucket->commit(bucket->end + run))
+            break;
+
+        for (uint32_t i = 0; i < run; ++i)
+        {
+            uint32_t cell = bucket->end++;
+            bucket->remaining--;
+            out[done++] = assign(*bucket, cell);
+        }
+        if (bucket->remaining == 0)
+            free_buckets.pop_back();
     }
-    else
+    return done;
+}
+
+template<size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline auto object_pool<obj_size, obj_align, objects_per_bucket>::reserve_slots(uint32_t count) -> uint32_t
+{
+    uint32_t fresh = count > free_slot_count ? count - free_slot_count : 0;
+    if (fresh > MAX_HANDLES - slot_count)
+        fresh = MAX_HANDLES - slot_count;
+    if (fresh == 0)
+        return std::min(count, free_slot_count);
+
+    uint32_t end = slot_count + fresh;
+    for (uint32_t c = slot_count / SLOTS_PER_CHUNK; c <= (end - 1) / SLOTS_PER_CHUNK; ++c)
     {
-        auto *mem = &bucket.objects[bucket.end++];
-        alloc.memory = mem;
-        alloc._reserved = &bucket;
+        if (c == slot_chunks.size())
+        {
+            std::unique_ptr<reserved_region> chunk{ new reserved_region };
+            if (!chunk->reserve(size_t(SLOTS_PER_CHUNK) * sizeof(handle_slot)))
+                return 0;
+            slot_chunks.push_back(std::move(chunk));
+        }
+
+        uint32_t used = end - c * SLOTS_PER_CHUNK;
+        used = used < SLOTS_PER_CHUNK ? used : SLOTS_PER_CHUNK;
+        if (!slot_chunks[c]->commit(size_t(used) * sizeof(handle_slot)))
+            return 0;
     }
+    return free_slot_count + fresh;
+}
+
+template<size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline auto object_pool<obj_size, obj_align, objects_per_bucket>::take_slot() -> uint32_t
+{
+    if (free_slot_head == FREE_END)
+        return slot_count++;
+
+    uint32_t slot = free_slot_head;
+    free_slot_head = slot_at(slot).next_free;
+    if (free_slot_head == FREE_END)
+        free_slot_tail = FREE_END;
+    free_slot_count--;
+    return slot;
+}
 
-    bucket.remaining--;
+template<size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline auto object_pool<obj_size, obj_align, objects_per_bucket>::assign(bucket_t &bucket, uint32_t cell) -> allocation
+{
+    uint32_t slot = take_slot();
+    handle_slot &entry = slot_at(slot);
+    entry.memory = &bucket.objects()[cell];
+    entry.bucket = &bucket;
+    bucket.owner()[cell] = slot + 1;
+    alloc_count++;
+
+    allocation alloc;
+    alloc.memory = entry.memory;
+    alloc.handle = (entry.generation << HANDLE_SLOT_BITS) | (slot + 1);
+    alloc._reserved = &bucket;
     return alloc;
 }
 
 template<size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
 inline auto object_pool<obj_size, obj_align, objects_per_bucket>::free(const allocation & alloc) -> void
 {
-    auto &bucket = *(bucket_t *)alloc._reserved;
+    uint32_t slot = (alloc.handle & HANDLE_SLOT_MASK) - 1;
+    handle_slot &entry = slot_at(slot);
+    auto &bucket = *entry.bucket;
+    auto obj = (obj_storage *)entry.memory;
+
+    entry.memory = nullptr;
+    entry.bucket = nullptr;
+    entry.generation = (entry.generation + 1) & 0xFF;
+    entry.next_free = FREE_END;
+    if (free_slot_tail != FREE_END)
+        slot_at(free_slot_tail).next_free = slot;
+    else
+        free_slot_head = slot;
+    free_slot_tail = slot;
+    free_slot_count++;
+    free_count++;
+
     if (bucket.remaining == 0)
     {
         free_buckets.push_back(&bucket);
     }
+    bucket.release_cell(uint32_t(obj - bucket.objects()));
+}
 
-    auto obj = (obj_storage *)alloc.memory;
-    auto idx = uint32_t(obj - &bucket.objects[0]);
-    
-    if (idx == bucket.end + 1)
+template<size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline auto object_pool<obj_size, obj_align, objects_per_bucket>::free_n(const allocation *allocs, uint32_t count) -> void
+{
+    for (uint32_t i = 0; i < count; ++i)
+        free(allocs[i]);
+}
+
+template<size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline auto object_pool<obj_size, obj_align, objects_per_bucket>::resolve(uint32_t handle) const -> void *
+{
+    uint32_t index = handle & HANDLE_SLOT_MASK;
+    if (index == 0 || index > slot_count)
+        return nullptr;
+
+    const handle_slot &entry = slot_at(index - 1);
+    if (!entry.memory || entry.generation != (handle >> HANDLE_SLOT_BITS))
+        return nullptr;
+    return entry.memory;
+}
+
+template<size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline auto object_pool<obj_size, obj_align, objects_per_bucket>::usage() const -> pool_usage
+{
+    pool_usage u{};
+    u.buckets = uint32_t(buckets.size());
+    for (auto &chunk : slot_chunks)
     {
-        bucket.end--;
+        u.reserved_bytes += chunk->capacity();
+        u.committed_bytes += chunk->committed();
     }
-    else
+    for (auto &b : buckets)
     {
-        auto node = (typename bucket_t::free_node *)obj;
-        node->next = bucket.free_head;
-        bucket.free_head = idx;
+        uint32_t live = objects_per_bucket - b->remaining;
+        u.live += live;
+        u.free_cells += b->end - live;
+        u.reserved_bytes += b->storage.capacity() + b->owners.capacity();
+        u.committed_bytes += b->storage.committed() + b->owners.committed();
     }
-
-    bucket.remaining++;
+    u.allocs = alloc_count;
+    u.frees = free_count;
+    return u;
 }
 
 template<size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
 inline auto object_pool<obj_size, obj_align, objects_per_bucket>::collect() -> void
 {
-    for (int i = 0; i < free_buckets.size(); ++i)
+    bool spare = false;
+    buckets.erase(std::remove_if(buckets.begin(), buckets.end(), [&spare](const std::unique_ptr<bucket_t> &b)
     {
-        bucket_t &bucket = free_buckets[i];
-        if (bucket.remaining == objects_per_bucket)
-        {
-            for (auto iter = buckets.begin(); iter != buckets.end(); ++iter)
-            {
-                if (iter->get() == &bucket)
-                {
-                    buckets.erase(iter);
-                    break;
-                }
-            }
+        if (b->remaining != objects_per_bucket)
+            return false;
+        if (spare)
+            return true;
+        spare = true;
+        return false;
+    }), buckets.end());
+    sort_free_buckets();
+}
 
-            free_buckets.erase(free_buckets().begin() + i);
-            --i;
-        }
+template<size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+template <typename relocate>
+inline auto object_pool<obj_size, obj_align, objects_per_bucket>::compact(uint32_t max_moves, relocate &&on_move) -> uint32_t
+{
+    // Free cells of empty buckets don't count, they are already as
+    // compact as they get
+    uint64_t holes = 0;
+    for (auto &b : buckets)
+    {
+        if (b->remaining != objects_per_bucket)
+            holes += b->remaining;
     }
+    if (holes < objects_per_bucket)
+        return 0;
+
+    std::sort(buckets.begin(), buckets.end(), [](const std::unique_ptr<bucket_t> &l, const std::unique_ptr<bucket_t> &r)
+    {
+        return l->storage.data() < r->storage.data();
+    });
+
+    // Fill holes front to back from objects taken back to front
+    size_t target = 0;
+    size_t source = buckets.size();
+    uint32_t moved = 0;
+    while (moved < max_moves)
+    {
+        while (target < buckets.size() && buckets[target]->remaining == 0)
+            ++target;
+        while (source > 0 && buckets[source - 1]->remaining == objects_per_bucket)
+            --source;
+        if (source == 0 || target >= source - 1)
+            break;
+
+        bucket_t &from = *buckets[source - 1];
+        bucket_t &to = *buckets[target];
+        if (to.free_head == FREE_END && !to.commit(to.end + 1))
+            break;
+
+        uint32_t src_cell = from.end - 1;
+        while (from.owner()[src_cell] == 0)
+            --src_cell;
+        uint32_t slot = from.owner()[src_cell] - 1;
+
+        uint32_t dst_cell = to.take_cell();
+        memcpy(&to.objects()[dst_cell], &from.objects()[src_cell], sizeof(obj_storage));
+        to.owner()[dst_cell] = slot + 1;
+        from.release_cell(src_cell);
+
+        handle_slot &entry = slot_at(slot);
+        entry.memory = &to.objects()[dst_cell];
+        entry.bucket = &to;
+
+        allocation alloc;
+        alloc.memory = entry.memory;
+        alloc.handle = (entry.generation << HANDLE_SLOT_BITS) | (slot + 1);
+        alloc._reserved = &to;
+        on_move(alloc);
+        ++moved;
+    }
+
+    if (moved > 0)
+        collect();
+    return moved;
+}
+
+template<size_t obj_size, size_t obj_align, uint32_t objects_per_bucket>
+inline void object_pool<obj_size, obj_align, objects_per_bucket>::sort_free_buckets()
+{
+    free_buckets.clear();
+    for (auto &b : buckets)
+    {
+        if (b->remaining > 0)
+            free_buckets.push_back(b.get());
+    }
+    std::sort(free_buckets.begin(), free_buckets.end(), [](bucket_t *l, bucket_t *r)
+    {
+        return l->storage.data() > r->storage.data();
+    });
 }
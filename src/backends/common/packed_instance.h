@@ -0,0 +1,100 @@
+#pragma once
+
+#include "renderer.h"
+#include <stdint.h>
+#include <string.h>
+
+// 32 byte alternative to the backends' 64 byte sprite_instance, used when a
+// scene is switched to INSTANCE_PACKED. The translation stays full precision
+// since sprites far from the origin would visibly snap with halfs, while the
+// linear part, UVs and layer only need ~3 significant digits.
+struct packed_sprite_instance
+{
+    uint16_t linear[4];     // half m11, m12, m21, m22
+    float translation[2];   // m31, m32
+    uint8_t tint[4];        // unorm8 rgba
+    uint16_t uv[4];         // half uv0.x, uv0.y, uv1.x, uv1.y
+    uint16_t layer;         // half
+    uint16_t texture_id;
+};
+
+static_assert(sizeof(packed_sprite_instance) == 32, "packed_sprite_instance must stay 32 bytes");
+
+namespace packed_details
+{
+    // IEEE 754 binary16 with round-to-nearest-even, overflow goes to inf
+    inline uint16_t float_to_half(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        uint32_t sign = (bits >> 16) & 0x8000;
+        uint32_t exp = (bits >> 23) & 0xFF;
+        uint32_t mant = bits & 0x7FFFFF;
+
+        if (exp == 0xFF)
+            return uint16_t(sign | 0x7C00 | (mant ? 0x200 : 0));
+
+        int32_t half_exp = int32_t(exp) - 127 + 15;
+        if (half_exp >= 0x1F)
+            return uint16_t(sign | 0x7C00);
+
+        if (half_exp <= 0)
+        {
+            if (half_exp < -10)
+                return uint16_t(sign);
+
+            mant |= 0x800000;
+            uint32_t shift = uint32_t(14 - half_exp);
+            uint32_t half_mant = mant >> shift;
+            uint32_t rem = mant & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+            if (rem > halfway || (rem == halfway && (half_mant & 1)))
+                half_mant++;
+            return uint16_t(sign | half_mant);
+        }
+
+        uint32_t half = sign | (uint32_t(half_exp) << 10) | (mant >> 13);
+        uint32_t rem = mant & 0x1FFF;
+        if (rem > 0x1000 || (rem == 0x1000 && (half & 1)))
+            half++; // may carry into the exponent, which is still correct
+        return uint16_t(half);
+    }
+
+    inline uint8_t float_to_unorm8(float value)
+    {
+        if (!(value > 0))
+            return 0;
+        if (value >= 1)
+            return 255;
+        return uint8_t(value * 255.f + 0.5f);
+    }
+}
+
+template <typename instance>
+inline void pack_instance(const instance &in, packed_sprite_instance &out)
+{
+    using namespace packed_details;
+
+    out.linear[0] = float_to_half(in.transform.m11);
+    out.linear[1] = float_to_half(in.transform.m12);
+    out.linear[2] = float_to_half(in.transform.m21);
+    out.linear[3] = float_to_half(in.transform.m22);
+    out.translation[0] = in.transform.m31;
+    out.translation[1] = in.transform.m32;
+    out.tint[0] = float_to_unorm8(in.tint.r);
+    out.tint[1] = float_to_unorm8(in.tint.g);
+    out.tint[2] = float_to_unorm8(in.tint.b);
+    out.tint[3] = float_to_unorm8(in.tint.a);
+    out.uv[0] = float_to_half(in.uv0.x);
+    out.uv[1] = float_to_half(in.uv0.y);
+    out.uv[2] = float_to_half(in.uv1.x);
+    out.uv[3] = float_to_half(in.uv1.y);
+    out.layer = float_to_half(in.layer);
+    out.texture_id = uint16_t(in.texture_id);
+}
+
+inline uint32_t instance_stride(instance_format format, uint32_t full_size)
+{
+    return format == INSTANCE_PACKED ? uint32_t(sizeof(packed_sprite_instance)) : full_size;
+}
@@ -0,0 +1,289 @@
+#pragma once
+
+#include "renderer.h"
+#include "renderer_math.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RD_PARTICLES_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RD_PARTICLES_NEON
+#endif
+
+namespace particle_details
+{
+    // Advances `n` particles by `dt`. Velocity is integrated before
+    // position, and `age` is normalized so a particle dies at 1.
+    inline void integrate(
+        float *px, float *py, float *vx, float *vy,
+        float *age, const float *inv_life,
+        size_t n, vec2 accel, float dt)
+    {
+        size_t i = 0;
+
+#if defined(RD_PARTICLES_SSE2)
+        const __m128 sdt = _mm_set1_ps(dt);
+        const __m128 sax = _mm_set1_ps(accel.x * dt);
+        const __m128 say = _mm_set1_ps(accel.y * dt);
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(px + i), y = _mm_loadu_ps(py + i);
+            __m128 dx = _mm_add_ps(_mm_loadu_ps(vx + i), sax);
+            __m128 dy = _mm_add_ps(_mm_loadu_ps(vy + i), say);
+            __m128 a = _mm_loadu_ps(age + i), il = _mm_loadu_ps(inv_life + i);
+
+            _mm_storeu_ps(vx + i, dx);
+            _mm_storeu_ps(vy + i, dy);
+            _mm_storeu_ps(px + i, _mm_add_ps(x, _mm_mul_ps(dx, sdt)));
+            _mm_storeu_ps(py + i, _mm_add_ps(y, _mm_mul_ps(dy, sdt)));
+            _mm_storeu_ps(age + i, _mm_add_ps(a, _mm_mul_ps(il, sdt)));
+        }
+#elif defined(RD_PARTICLES_NEON)
+        const float32x4_t sdt = vdupq_n_f32(dt);
+        const float32x4_t sax = vdupq_n_f32(accel.x * dt);
+        const float32x4_t say = vdupq_n_f32(accel.y * dt);
+        for (; i + 4 <= n; i += 4)
+        {
+            float32x4_t dx = vaddq_f32(vld1q_f32(vx + i), sax);
+            float32x4_t dy = vaddq_f32(vld1q_f32(vy + i), say);
+
+            vst1q_f32(vx + i, dx);
+            vst1q_f32(vy + i, dy);
+            vst1q_f32(px + i, vmlaq_f32(vld1q_f32(px + i), dx, sdt));
+            vst1q_f32(py + i, vmlaq_f32(vld1q_f32(py + i), dy, sdt));
+            vst1q_f32(age + i, vmlaq_f32(vld1q_f32(age + i), vld1q_f32(inv_life + i), sdt));
+        }
+#endif
+
+        for (; i < n; ++i)
+        {
+            vx[i] += accel.x * dt;
+            vy[i] += accel.y * dt;
+            px[i] += vx[i] * dt;
+            py[i] += vy[i] * dt;
+            age[i] += inv_life[i] * dt;
+        }
+    }
+
+    inline float lerp(float a, float b, float t)
+    {
+        return a + (b - a) * t;
+    }
+
+    inline color lerp(const color &a, const color &b, float t)
+    {
+        return color{ lerp(a.r, b.r, t), lerp(a.g, b.g, t), lerp(a.b, b.b, t), lerp(a.a, b.a, t) };
+    }
+}
+
+// A particle emitter owned by a scene. Particle state is kept as separate
+// arrays so the integration step can run 4 particles at a time, and the
+// instances are written straight into the mapped instance buffer.
+template <typename instance, template <class I> class instance_buffer, typename errors>
+class particle_emitter_state
+{
+public:
+    using batch = std::pair<texture_array *, instance_buffer<instance>>;
+
+    particle_emitter_state(const particle_emitter_state &) = delete;
+    particle_emitter_state &operator=(const particle_emitter_state &) = delete;
+
+    particle_emitter_state(const emitter_params *params)
+        : params(*params), live(0), emit_debt(0), rng(0x9E3779B9u),
+          bounds_min{ 0, 0 }, bounds_max{ 0, 0 }
+    {
+        texture_id = rd_get_texture_index(params->tex);
+        gpu.first = rd_get_texture_array(params->tex);
+
+        px.resize(params->max_particles);
+        py.resize(params->max_particles);
+        vx.resize(params->max_particles);
+        vy.resize(params->max_particles);
+        age.resize(params->max_particles);
+        inv_life.resize(params->max_particles);
+    }
+
+    float layer() const
+    {
+        return params.layer;
+    }
+
+    void set_position(vec2 pos)
+    {
+        params.position = pos;
+    }
+
+    uint32_t count() const
+    {
+        return live;
+    }
+
+    // Whether any live particle's quad can touch the given world rectangle,
+    // using the bounds gathered by the last update and emits since
+    bool overlaps(vec2 world_min, vec2 world_max) const
+    {
+        if (live == 0)
+            return false;
+
+        float extent = std::max(std::abs(params.size_start), std::abs(params.size_end)) * 0.5f;
+        return
+            bounds_min.x - extent <= world_max.x && bounds_max.x + extent >= world_min.x &&
+            bounds_min.y - extent <= world_max.y && bounds_max.y + extent >= world_min.y;
+    }
+
+    void emit(uint32_t count)
+    {
+        count = std::min(count, params.max_particles - live);
+        if (count == 0)
+            return;
+
+        if (live == 0)
+        {
+            bounds_min = params.position;
+            bounds_max = params.position;
+        }
+        else
+        {
+            grow_bounds(params.position.x, params.position.y);
+        }
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t idx = live++;
+            px[idx] = params.position.x;
+            py[idx] = params.position.y;
+            vx[idx] = particle_details::lerp(params.velocity_min.x, params.velocity_max.x, random());
+            vy[idx] = particle_details::lerp(params.velocity_min.y, params.velocity_max.y, random());
+            age[idx] = 0;
+
+            float life = particle_details::lerp(params.lifetime_min, params.lifetime_max, random());
+            inv_life[idx] = life > 0 ? 1 / life : 1e9f;
+        }
+    }
+
+    void update(float dt)
+    {
+        if (params.emit_rate > 0)
+        {
+            emit_debt += params.emit_rate * dt;
+            uint32_t n = (uint32_t)emit_debt;
+            emit_debt -= n;
+            emit(n);
+        }
+
+        particle_details::integrate(
+            px.data(), py.data(), vx.data(), vy.data(),
+            age.data(), inv_life.data(),
+            live, params.acceleration, dt
+        );
+
+        // Swap dead particles out to the end, and bound the survivors
+        bounds_min = vec2{ FLT_MAX, FLT_MAX };
+        bounds_max = vec2{ -FLT_MAX, -FLT_MAX };
+        for (uint32_t i = 0; i < live;)
+        {
+            if (age[i] >= 1)
+            {
+                uint32_t last = --live;
+                px[i] = px[last];
+                py[i] = py[last];
+                vx[i] = vx[last];
+                vy[i] = vy[last];
+                age[i] = age[last];
+                inv_life[i] = inv_life[last];
+            }
+            else
+            {
+                grow_bounds(px[i], py[i]);
+                ++i;
+            }
+        }
+    }
+
+    bool prepare(device *dev, instance_format format)
+    {
+        if (live == 0)
+            return true;
+
+        auto &buffer = gpu.second;
+        if (!buffer.start_upload(dev, live, format))
+            return errors::append_ret(false, "Failed to begin upload of particles");
+
+        if (format == INSTANCE_FULL)
+        {
+            instance *out = buffer.reserve(live);
+            for (uint32_t i = 0; i < live; ++i)
+                build(i, out[i]);
+        }
+        else
+        {
+            // The buffer packs each instance as it is pushed
+            for (uint32_t i = 0; i < live; ++i)
+            {
+                instance inst;
+                build(i, inst);
+                buffer.push(inst);
+            }
+        }
+
+        if (!buffer.finish(dev))
+            return errors::append_ret(false, "Failed to finish upload of particles");
+
+        return true;
+    }
+
+    const batch &batches() const
+    {
+        return gpu;
+    }
+
+private:
+    void grow_bounds(float x, float y)
+    {
+        bounds_min.x = std::min(bounds_min.x, x);
+        bounds_min.y = std::min(bounds_min.y, y);
+        bounds_max.x = std::max(bounds_max.x, x);
+        bounds_max.y = std::max(bounds_max.y, y);
+    }
+
+    void build(uint32_t i, instance &inst) const
+    {
+        float t = age[i];
+        float size = particle_details::lerp(params.size_start, params.size_end, t);
+
+        inst.transform = matrix2d{ size, 0, 0, size, px[i], py[i] };
+        inst.tint = particle_details::lerp(params.color_start, params.color_end, t);
+        inst.uv0 = params.uv_topleft;
+        inst.uv1 = params.uv_bottomright;
+        inst.layer = params.layer;
+        inst.texture_id = texture_id;
+    }
+
+    float random()
+    {
+        // xorshift32, plenty for particle spread
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return float(rng >> 8) * (1.f / 16777216.f);
+    }
+
+    emitter_params params;
+    uint32_t texture_id;
+    uint32_t live;
+    float emit_debt;
+    uint32_t rng;
+    // Particle positions only, the quads reach half a size further
+    vec2 bounds_min, bounds_max;
+
+    std::vector<float> px, py;
+    std::vector<float> vx, vy;
+    std::vector<float> age, inv_life;
+
+    batch gpu;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "renderer.h"
+#include "renderer_math.h"
+#include "object_pool.h"
+#include <algorithm>
+#include <vector>
+
+// Sprites shared by every instance of a prefab, stored once as ready-made
+// instances relative to the prefab's root. Children are grouped by texture
+// array so each cell uploads one batch per array no matter how many
+// prefabs it holds.
+template <typename instance>
+struct prefab_def
+{
+    struct part
+    {
+        texture_array *tary;
+        std::vector<instance> children;
+    };
+
+    std::vector<part> parts;
+    uint32_t child_count = 0;
+    uint32_t instance_count = 0;
+
+    template <typename make_instance>
+    prefab_def(const sprite_params *children, uint32_t count, make_instance &&make)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            texture_array *tary = rd_get_texture_array(children[i].tex);
+            auto it = std::find_if(parts.begin(), parts.end(), [tary](const part &p) { return p.tary == tary; });
+            if (it == parts.end())
+            {
+                parts.push_back(part{ tary, {} });
+                it = parts.end() - 1;
+            }
+            it->children.push_back(make(children[i]));
+        }
+
+        // Lower layers first within each array, like the other opaque batches
+        for (auto &p : parts)
+        {
+            std::stable_sort(p.children.begin(), p.children.end(), [](const instance &l, const instance &r)
+            {
+                return l.layer < r.layer;
+            });
+        }
+        child_count = count;
+    }
+};
+
+template <typename instance>
+struct prefab_instance_state
+{
+    const prefab_def<instance> *def;
+    matrix2d transform;
+    pool_allocation alloc;
+    // Where the instance sits in its grid cell's list
+    uint32_t cell_index;
+};
+
+// A child placed in the world: its own transform followed by the root's
+template <typename instance>
+inline instance expand_child(const instance &child, const matrix2d &root)
+{
+    instance inst = child;
+    inst.transform = child.transform * root;
+    return inst;
+}
@@ -4,9 +4,21 @@
 #include "sg_details.h"
 #include "renderer_math.h"
 #include "object_pool.h"
-#include <unordered_map>
-#include <unordered_set>
+#include "concurrent_pool.h"
+#include "mapped_file.h"
+#include "scene_snapshot.h"
+#include "tilemap.h"
+#include "particles.h"
+#include "packed_instance.h"
+#include "mutation_queue.h"
+#include "prefab.h"
+#include "scene_streamer.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <type_traits>
 #include <vector>
+#include "hashmap.h"
 
 enum class sprite_class
 {
@@ -15,21 +27,43 @@ enum class sprite_class
     translucents,
 };
 
-template <typename object, typename instance, template <class I> class instance_buffer, typename errors>
+// `group_dim` is the width and height, in cells, of the blocks cells are
+// allocated in. Larger groups mean fewer hash lookups but more memory spent
+// on empty cells in sparse levels.
+//
+// `object` keeps everything a batch needs in `hot`, an `instance` that is
+// uploaded as-is. Its other fields (texture, tags, pool allocation...) are
+// cold and only read when sprites are placed, hidden or re-sorted.
+template <
+    typename object, typename instance,
+    template <class I> class instance_buffer, typename errors,
+    int32_t group_dim = 8
+>
 class scene_graph
 {
     template <typename K, typename V>
-    using hashmap = std::unordered_map<K, V>;
+    using hashmap = ::hashmap<K, V, HashPolicy::Fast>;
     template <typename T>
-    using hashset = std::unordered_set<T>;
+    using hashset = ::hashmap<T, void, HashPolicy::Fast>;
     template <typename T>
     using vec = std::vector<T>;
 
 public:
     using coord = sg_details::coord;
     using handle = object*;
+    // What callers hold on to, see object_pool::resolve
+    using sprite_id = uint32_t;
+    using prefab_instance_id = uint32_t;
     using unordered_batch = hashmap<texture_array *, instance_buffer<instance>>;
     using ordered_batch = vec<std::pair<texture_array *, instance_buffer<instance>>>;
+    using translucent_item = std::pair<texture_array *, const instance *>;
+    using tilemap_type = tilemap_layer<instance, instance_buffer, errors>;
+    using tile_batches = vec<const typename tilemap_type::batch *>;
+    using emitter_type = particle_emitter_state<instance, instance_buffer, errors>;
+    using particle_batches = vec<const typename emitter_type::batch *>;
+    using prefab_type = prefab_def<instance>;
+    using prefab_instance_type = prefab_instance_state<instance>;
+    using streamer_type = scene_streamer<instance>;
     
     scene_graph(const scene_graph &) = delete;
     scene_graph &operator=(const scene_graph &) = delete;
@@ -38,6 +72,8 @@ private:
     struct opaque_group
     {
         hashset<handle> sprites;
+        uint32_t tags_present = 0;
+        uint32_t hidden_count = 0;
         bool dirty = true;
     };
     struct opaque_pool
@@ -46,10 +82,24 @@ private:
         unordered_batch batches;
         bool active = false;
     };
+    struct baked_segment
+    {
+        texture_array *tary;
+        const instance *data;
+        uint32_t count;
+        // Set once the grid has been rebuilt and the instances no longer
+        // live in the mapped snapshot
+        std::shared_ptr<const vec<instance>> storage;
+    };
     struct translucent_pool
     {
         vec<handle> sprites;
+        // Runs loaded from snapshots, merged with `sprites` by layer when
+        // the batches are built. They stay resident while streaming.
+        vec<baked_segment> baked;
         ordered_batch batches;
+        uint32_t tags_present = 0;
+        uint32_t hidden_count = 0;
         bool dirty = true;
         bool active = false;
 
@@ -57,22 +107,66 @@ private:
         {
             std::sort(sprites.begin(), sprites.end(), [](handle l, handle r) -> bool
             {
-                return l->layer < r->layer;
+                return l->hot.layer < r->hot.layer;
             });
             dirty = true;
         }
     };
+    struct prefab_pool
+    {
+        vec<prefab_instance_type *> instances;
+        unordered_batch batches;
+        bool dirty = true;
+        bool active = false;
+    };
+    struct baked_pool
+    {
+        // Segments usually point into a mapped snapshot and are uploaded as-is
+        vec<baked_segment> segments;
+        ordered_batch batches;
+        bool dirty = true;
+        bool active = false;
+    };
     struct grid_space
     {
         opaque_pool standard;
         opaque_pool statics;
         translucent_pool translucents;
+        baked_pool baked;
+        prefab_pool prefabs;
         uint32_t frames_occluded;
         bool active = false;
+
+        // Union of the tags of every sprite placed here since the space was
+        // created; may include tags no sprite carries anymore
+        uint32_t tags_present = 0;
+        // hidden_tags the batches were last built with
+        uint32_t built_mask = 0;
     };
     struct grid_group
     {
-        grid_space spaces[8][8];
+        grid_space spaces[group_dim][group_dim];
+    };
+    // A sprite edit recorded by a worker thread, applied at frame start
+    struct mutation
+    {
+        enum class kind_t : uint8_t
+        {
+            create, destroy, uv, layer, tex, transform, tint, hidden, tags,
+        };
+
+        kind_t kind;
+        sprite_id id;
+        union
+        {
+            vec2 uv[2];
+            float layer;
+            texture *tex;
+            matrix2d transform;
+            color tint;
+            bool hidden;
+            uint32_t tags;
+        };
     };
 
 public:
@@ -80,6 +174,8 @@ public:
     {
         const unordered_batch *standard;
         const unordered_batch *statics;
+        const unordered_batch *prefabs;
+        const ordered_batch *baked;
         const ordered_batch *translucents;
     };
     struct to_be_rendered_t
@@ -96,7 +192,10 @@ public:
     }
 
     inline scene_graph(vec2 grid_size)
-        : grid_size(grid_size)
+        : grid_size(grid_size), format(INSTANCE_FULL), hidden_tags(0),
+          camera_velocity(vec2{ 0, 0 }), last_camera_center(vec2{ 0, 0 }), has_camera_history(false),
+          prefetch_frames(6), prefetch_budget(2048), lod_pixels(0), threaded(false),
+          resident_budget(0), resident_bytes(0)
     {
     }
     
@@ -106,25 +205,43 @@ public:
         this->grid_size = grid_size;
     }
 
-    bool prepare_rendering(device *dev, camera *cam)
+    bool prepare_rendering(device *dev, camera *cam, const viewport *vp = nullptr)
     {
+        flush_mutations();
+        compact_prefabs();
+        count_pool_frame(pool_frames[SCENE_POOL_SPRITES], objects.usage());
+        count_pool_frame(pool_frames[SCENE_POOL_PREFAB_INSTANCES], prefab_objects.usage());
+
         matrix2d cam_transform;
         rd_get_camera_transform(cam, &cam_transform);
         previously_rendered.clear();
         previously_rendered.swap(to_be_rendered_items);
 
-        coord c0 = get_coord(transform_point(cam_transform, vec2{ -1, 1 }));
-        coord c1 = get_coord(transform_point(cam_transform, vec2{ 1, 1 }));
-        coord c2 = get_coord(transform_point(cam_transform, vec2{ -1, -1 }));
-        coord c3 = get_coord(transform_point(cam_transform, vec2{ 1, -1 }));
-        int32_t minx = std::min(std::min(c0.x, c1.x), std::min(c2.x, c3.x)) - 1;
-        int32_t maxx = std::max(std::max(c0.x, c1.x), std::max(c2.x, c3.x)) + 1;
-        int32_t miny = std::min(std::min(c0.y, c1.y), std::min(c2.y, c3.y)) - 1;
-        int32_t maxy = std::max(std::max(c0.y, c1.y), std::max(c2.y, c3.y)) + 1;
+        vec2 p0 = transform_point(cam_transform, vec2{ -1, 1 });
+        vec2 p1 = transform_point(cam_transform, vec2{ 1, 1 });
+        vec2 p2 = transform_point(cam_transform, vec2{ -1, -1 });
+        vec2 p3 = transform_point(cam_transform, vec2{ 1, -1 });
+
+        vec2 world_min = vec2{
+            std::min(std::min(p0.x, p1.x), std::min(p2.x, p3.x)),
+            std::min(std::min(p0.y, p1.y), std::min(p2.y, p3.y)),
+        };
+        vec2 world_max = vec2{
+            std::max(std::max(p0.x, p1.x), std::max(p2.x, p3.x)),
+            std::max(std::max(p0.y, p1.y), std::max(p2.y, p3.y)),
+        };
 
-        for (int32_t y = miny; y <= maxy; ++y)
+        // NDC spans 2 units vertically, which the viewport maps to its height
+        float view_height = len(p0 - p2);
+        lod_pixels = vp && view_height > 0 ? vp->h / view_height : 0;
+
+        cell_rect visible = cells_covering(world_min, world_max);
+        if (!stream(visible))
+            return false;
+
+        for (int32_t y = visible.miny; y <= visible.maxy; ++y)
         {
-            for (int32_t x = minx; x <= maxx; ++x)
+            for (int32_t x = visible.minx; x <= visible.maxx; ++x)
             {
                 coord c{ x, y };
                 if (grid_space *space = lookup(c))
@@ -147,8 +264,190 @@ public:
             }
         }
 
+        track_camera(transform_point(cam_transform, vec2{ 0, 0 }), world_max - world_min);
+        if (!prefetch(dev, visible, world_min, world_max))
+            return false;
+
+        visible_tile_batches.clear();
+        for (auto &map : tilemaps)
+        {
+            if (!map->prepare(dev, format, world_min, world_max, visible_tile_batches))
+                return false;
+        }
+
+        // Emitters keep simulating off screen but only visible ones upload
+        visible_particle_batches.clear();
+        for (auto &em : emitters)
+        {
+            if (!em->overlaps(world_min, world_max))
+                continue;
+            if (!em->prepare(dev, format))
+                return false;
+            visible_particle_batches.push_back(&em->batches());
+        }
+
         return true;
     }
+    // Cells along the camera's predicted path for the next `frames` frames
+    // are prepared early, uploading at most `instance_budget` instances per
+    // frame. 0 frames turns prediction off.
+    void set_prefetch(uint32_t frames, uint32_t instance_budget)
+    {
+        prefetch_frames = frames;
+        prefetch_budget = instance_budget;
+    }
+
+    // Flipping a tag only changes the mask; cells notice the change and
+    // rebuild the affected batches the next time they are prepared
+    void set_tag_visible(uint32_t tag, bool visible)
+    {
+        if (tag >= 32)
+            return;
+
+        uint32_t bit = 1u << tag;
+        hidden_tags = visible ? hidden_tags & ~bit : hidden_tags | bit;
+    }
+    bool is_tag_visible(uint32_t tag) const
+    {
+        return tag >= 32 || (hidden_tags & (1u << tag)) == 0;
+    }
+    void set_hidden(sprite_id id, bool hidden)
+    {
+        mutation m{ mutation::kind_t::hidden, id, {} };
+        m.hidden = hidden;
+        submit(m);
+    }
+    void set_tags(sprite_id id, uint32_t tags)
+    {
+        mutation m{ mutation::kind_t::tags, id, {} };
+        m.tags = tags;
+        submit(m);
+    }
+
+    vec2 get_grid_size() const
+    {
+        return grid_size;
+    }
+    // Moves every sprite and baked instance into a grid with the new cell
+    // size. All batches are rebuilt on the next prepare_rendering.
+    bool set_grid_size(vec2 new_size)
+    {
+        if (!(new_size.x > 0 && new_size.y > 0 && std::isfinite(new_size.x) && std::isfinite(new_size.y)))
+            return errors::set_ret(false, "Grid cells must have a positive, finite size");
+        if (new_size.x == grid_size.x && new_size.y == grid_size.y)
+            return true;
+
+        return rebuild_grid(new_size);
+    }
+    // Picks a cell size so the median sprite shares its cell with about
+    // `sprites_per_cell` sprites and rebuilds the grid with it. Each call
+    // rescales by at most 8x, so very lopsided grids may need a few calls.
+    bool retune_grid(uint32_t sprites_per_cell)
+    {
+        if (sprites_per_cell == 0)
+            return errors::set_ret(false, "Target sprites per cell must be non-zero");
+
+        // Occupancy histogram in power-of-two buckets, weighted by the
+        // number of sprites in the cell. `squares` gives the sprite-weighted
+        // mean occupancy inside each bucket.
+        uint64_t histogram[32] = { 0 };
+        uint64_t squares[32] = { 0 };
+        uint64_t total = 0;
+        for (auto &pair : groups)
+        {
+            for (auto &row : pair.second->spaces)
+            {
+                for (grid_space &space : row)
+                {
+                    uint32_t n = space_count(space);
+                    if (n == 0)
+                        continue;
+
+                    uint32_t bucket = 0;
+                    while ((n >> (bucket + 1)) != 0)
+                        bucket++;
+                    histogram[bucket] += n;
+                    squares[bucket] += uint64_t(n) * n;
+                    total += n;
+                }
+            }
+        }
+
+        if (total == 0)
+            return true;
+
+        uint32_t median = 0;
+        for (uint64_t seen = 0; median < 31; ++median)
+        {
+            seen += histogram[median];
+            if (seen * 2 >= total)
+                break;
+        }
+
+        float occupancy = float(double(squares[median]) / double(histogram[median]));
+        float scale = std::sqrt(float(sprites_per_cell) / occupancy);
+        scale = std::min(std::max(scale, 0.125f), 8.f);
+        if (std::abs(scale - 1) < 0.1f)
+            return true;
+
+        return set_grid_size(grid_size * scale);
+    }
+
+    instance_format instance_layout() const
+    {
+        return format;
+    }
+    // Every batch is re-uploaded in the new layout the next time it is drawn
+    void set_instance_layout(instance_format new_format)
+    {
+        if (new_format == format)
+            return;
+
+        format = new_format;
+        for (auto &pair : groups)
+        {
+            for (auto &row : pair.second->spaces)
+            {
+                for (grid_space &space : row)
+                {
+                    for (auto &group : space.standard.sprites)
+                        group.second.dirty = true;
+                    for (auto &group : space.statics.sprites)
+                        group.second.dirty = true;
+                    space.translucents.dirty = true;
+                    space.baked.dirty = true;
+                    space.prefabs.dirty = true;
+                }
+            }
+        }
+        for (auto &map : tilemaps)
+            map->invalidate();
+    }
+    const tile_batches &visible_tiles() const
+    {
+        return visible_tile_batches;
+    }
+    const particle_batches &visible_particles() const
+    {
+        return visible_particle_batches;
+    }
+    // The array to sample a batch of `tary` from this frame: the lowest
+    // level of its LOD chain whose threshold the camera is still under.
+    // Slices and UVs match across levels, so the batch itself is unchanged.
+    texture_array *lod_for(texture_array *tary) const
+    {
+        if (lod_pixels <= 0)
+            return tary;
+
+        float max_pixels;
+        while (texture_array *lower = rd_get_texture_array_lod(tary, &max_pixels))
+        {
+            if (lod_pixels > max_pixels)
+                break;
+            tary = lower;
+        }
+        return tary;
+    }
     to_be_rendered_t to_be_rendered() const
     {
         return this;
@@ -164,10 +463,14 @@ public:
                     batch.standard = &space->standard.batches;
                 if (space->statics.active)
                     batch.statics = &space->statics.batches;
+                if (space->prefabs.active)
+                    batch.prefabs = &space->prefabs.batches;
+                if (space->baked.active)
+                    batch.baked = &space->baked.batches;
                 if (space->translucents.active)
                     batch.translucents = &space->translucents.batches;
 
-                return batch.standard || batch.statics || batch.translucents;
+                return batch.standard || batch.statics || batch.prefabs || batch.baked || batch.translucents;
             }
         }
 
@@ -175,7 +478,7 @@ public:
     }
     void collect_garbage(uint32_t deactivate_threshold)
     {
-        std::unordered_set<coord> kill;
+        hashset<coord> kill;
         for (coord c : recently_occluded)
         {
             if (grid_space *space = lookup(c))
@@ -211,13 +514,11 @@ public:
             if (grid_group == groups.end())
                 continue;
 
-            for (auto &row : grid_group->second.spaces)
+            for (auto &row : grid_group->second->spaces)
             {
                 for (auto &space : row)
                 {
-                    if (!(space.standard.sprites.empty() &&
-                          space.statics.sprites.empty() &&
-                          space.translucents.sprites.empty()))
+                    if (!space_empty(space))
                     {
                         goto next;
                     }
@@ -232,60 +533,385 @@ public:
         recently_emptied.clear();
     }
 
-    handle create_object(const sprite_params *params)
+    // Once more than `budget` bytes of baked instances are loaded, groups
+    // away from the camera are paged out to `page_path` and read back on a
+    // background thread when the camera comes within a group of them.
+    // Live sprites always stay resident. A null path turns streaming off
+    // and loads everything back in.
+    bool set_streaming(const char *page_path, uint64_t budget)
     {
-        pool_allocation alloc = objects.alloc();
-        handle obj = new (alloc.memory) object(alloc, params);
-        place_object(obj);
-        return obj;
+        if (streamer)
+        {
+            if (!page_in_all())
+                return false;
+            streamer.reset();
+            clean_groups.clear();
+        }
+
+        resident_budget = budget;
+        if (!page_path)
+            return true;
+
+        std::unique_ptr<streamer_type> s(new streamer_type);
+        if (!s->open(page_path))
+            return errors::set_ret(false, "Failed to create the scene page file");
+
+        streamer = std::move(s);
+        resident_bytes = 0;
+        for (auto &pair : groups)
+            resident_bytes += baked_bytes(*pair.second);
+        return true;
     }
-    void destroy_object(handle h)
+    bool get_pool_stats(scene_pool which, pool_stats *stats)
     {
-        remove_object(h);
-        objects.free(h->alloc);
+        pool_usage u;
+        if (which == SCENE_POOL_SPRITES)
+            u = objects.usage();
+        else if (which == SCENE_POOL_PREFAB_INSTANCES)
+            u = prefab_objects.usage();
+        else
+            return errors::set_ret(false, "Unknown scene pool");
+
+        const pool_frame &frame = pool_frames[which];
+        stats->live = u.live;
+        stats->buckets = u.buckets;
+        stats->reserved_bytes = u.reserved_bytes;
+        stats->committed_bytes = u.committed_bytes;
+        stats->free_cells = u.free_cells;
+        stats->frame_allocs = frame.frame_allocs;
+        stats->frame_frees = frame.frame_frees;
+        stats->total_allocs = u.allocs;
+        stats->total_frees = u.frees;
+        uint64_t used = uint64_t(u.live) + u.free_cells;
+        stats->fragmentation = used ? float(u.free_cells) / float(used) : 0.f;
+        return true;
+    }
+
+    uint64_t get_resident_bytes()
+    {
+        if (streamer)
+            return resident_bytes;
+
+        uint64_t bytes = 0;
+        for (auto &pair : groups)
+            bytes += baked_bytes(*pair.second);
+        return bytes;
+    }
+
+    // While threaded, sprites may be created, destroyed and edited from any
+    // thread. Each thread queues its edits and the queues are applied in one
+    // go when the next frame is prepared, or by flush_mutations. Sprite
+    // fields then only change during the flush, so reading them is safe
+    // whenever the scene isn't being drawn. Switch modes only while no
+    // worker is touching the scene.
+    void set_threaded(bool enable)
+    {
+        if (!enable)
+            flush_mutations();
+        threaded = enable;
+    }
+    bool is_threaded() const
+    {
+        return threaded;
     }
-    void move_object(handle obj, const matrix2d &new_transform)
+    void flush_mutations()
     {
-        coord old_c = get_coord(position_of(obj));
-        coord new_c = get_coord(position_of(new_transform));
+        // Sprites may be freed directly by any thread, so buckets are
+        // trimmed whether or not anything was queued
+        objects.trim();
+
+        applying.clear();
+        mutations.drain_into(applying);
+        if (applying.empty())
+            return;
 
-        if (old_c == new_c)
+        // New sprites are placed first so one thread can edit a sprite
+        // another created during the same frame
+        vec<handle> created;
+        for (const mutation &m : applying)
         {
-            obj->transform = new_transform;
-            updated_field(obj);
+            if (m.kind == mutation::kind_t::create)
+                created.push_back(resolve(m.id));
         }
-        else
+        place_objects(created.data(), created.size());
+
+        destroyed.clear();
+        for (const mutation &m : applying)
         {
-            remove_object(obj);
-            obj->transform = new_transform;
-            place_object(obj);
+            if (m.kind == mutation::kind_t::create)
+                continue;
+            if (!destroyed.empty() && destroyed.count(m.id))
+                continue;
+
+            if (m.kind == mutation::kind_t::destroy)
+            {
+                handle obj = resolve(m.id);
+                if (!obj)
+                    continue;
+                remove_object(obj);
+                destroyed.insert(m.id);
+            }
+            else
+            {
+                apply(m);
+            }
         }
+
+        // Freed last, later records in the batch may still name them
+        for (sprite_id id : destroyed)
+            objects.free(resolve(id)->alloc);
     }
-    void change_texture(handle obj, texture *tex)
+
+    // Returns 0 once the pool is out of handles
+    sprite_id create_object(const sprite_params *params)
     {
-        if (obj->type != sprite_class::translucents)
-        {
-            remove_object(obj);
-            obj->tex = tex;
+        // Safe from any thread, each allocates from its own free list
+        pool_allocation alloc = objects.alloc();
+        if (!alloc.memory)
+            return errors::set_ret(sprite_id(0), "Too many sprites in the scene");
+
+        handle obj = new (alloc.memory) object(alloc, params);
+        if (threaded)
+            mutations.push(mutation{ mutation::kind_t::create, alloc.handle, {} });
+        else
             place_object(obj);
+        return alloc.handle;
+    }
+    // Creates `count` sprites in adjacent memory where the pool allows,
+    // writing their ids to `out`. Creates none if there's no room for all.
+    bool create_objects(const sprite_params *params, uint32_t count, sprite_id *out)
+    {
+        vec<pool_allocation> allocs(count);
+        uint32_t made = objects.alloc_n(count, allocs.data());
+        if (made < count)
+        {
+            objects.free_n(allocs.data(), made);
+            return errors::set_ret(false, "Too many sprites in the scene");
+        }
+
+        vec<mutation> created;
+        vec<handle> objs;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            handle obj = new (allocs[i].memory) object(allocs[i], &params[i]);
+            out[i] = allocs[i].handle;
+            if (threaded)
+                created.push_back(mutation{ mutation::kind_t::create, out[i], {} });
+            else
+                objs.push_back(obj);
         }
+        if (threaded)
+            mutations.push(created.data(), created.size());
         else
+            place_objects(objs.data(), objs.size());
+        return true;
+    }
+    void destroy_objects(const sprite_id *ids, uint32_t count)
+    {
+        if (threaded)
+        {
+            vec<mutation> destroys;
+            for (uint32_t i = 0; i < count; ++i)
+                destroys.push_back(mutation{ mutation::kind_t::destroy, ids[i], {} });
+            return mutations.push(destroys.data(), destroys.size());
+        }
+
+        vec<handle> objs;
+        vec<uint32_t> listed;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (handle h = resolve(ids[i]))
+            {
+                objs.push_back(h);
+                listed.push_back(i);
+            }
+        }
+        locate_objects(objs.data(), objs.size());
+
+        for (size_t i = 0; i < objs.size(); ++i)
+        {
+            // Freed right away, so an id listed twice no longer resolves
+            handle h = resolve(ids[listed[i]]);
+            if (!h)
+                continue;
+            remove_object(h, batch_cells[i], *batch_spaces[i]);
+            objects.free(h->alloc);
+        }
+    }
+    void destroy_object(sprite_id id)
+    {
+        if (threaded)
+            return mutations.push(mutation{ mutation::kind_t::destroy, id, {} });
+
+        handle h = resolve(id);
+        if (!h)
+            return;
+        remove_object(h);
+        objects.free(h->alloc);
+    }
+    // The sprite `id` names, or null once it was destroyed. In threaded
+    // mode a sprite destroyed by a worker resolves until the next flush.
+    handle resolve(sprite_id id) const
+    {
+        return (handle)objects.resolve(id);
+    }
+    void move_object(sprite_id id, const matrix2d &new_transform)
+    {
+        mutation m{ mutation::kind_t::transform, id, {} };
+        m.transform = new_transform;
+        submit(m);
+    }
+    void change_texture(sprite_id id, texture *tex)
+    {
+        mutation m{ mutation::kind_t::tex, id, {} };
+        m.tex = tex;
+        submit(m);
+    }
+    void set_uv(sprite_id id, vec2 uv0, vec2 uv1)
+    {
+        mutation m{ mutation::kind_t::uv, id, {} };
+        m.uv[0] = uv0;
+        m.uv[1] = uv1;
+        submit(m);
+    }
+    void set_layer(sprite_id id, float layer)
+    {
+        mutation m{ mutation::kind_t::layer, id, {} };
+        m.layer = layer;
+        submit(m);
+    }
+    void set_tint(sprite_id id, const color &tint)
+    {
+        mutation m{ mutation::kind_t::tint, id, {} };
+        m.tint = tint;
+        submit(m);
+    }
+    // Prefabs are only created, placed and moved from the drawing thread,
+    // also in threaded mode
+    prefab_type *create_prefab(const sprite_params *children, uint32_t count)
+    {
+        if (!children || count == 0)
+            return errors::set_ret(nullptr, "Prefabs need at least one child sprite");
+        for (uint32_t i = 0; i < count; ++i)
         {
-            updated_field(obj);
+            if (!children[i].tex)
+                return errors::set_ret(nullptr, "Prefab children need a texture");
+            if (children[i].is_translucent)
+                return errors::set_ret(nullptr, "Prefab children can't be translucent");
         }
+
+        prefab_defs.emplace_back(new prefab_type(children, count, [](const sprite_params &params)
+        {
+            object child(pool_allocation(), &params);
+            return child.hot;
+        }));
+        return prefab_defs.back().get();
+    }
+    bool destroy_prefab(prefab_type *def)
+    {
+        if (def->instance_count != 0)
+            return errors::set_ret(false, "Prefab still has instances");
+
+        auto it = std::find_if(prefab_defs.begin(), prefab_defs.end(),
+            [def](const std::unique_ptr<prefab_type> &p) { return p.get() == def; });
+        if (it != prefab_defs.end())
+            prefab_defs.erase(it);
+        return true;
+    }
+    // Returns 0 once the pool is out of handles
+    prefab_instance_id instantiate_prefab(prefab_type *def, const matrix2d &transform)
+    {
+        pool_allocation alloc = prefab_objects.alloc();
+        if (!alloc.memory)
+            return errors::set_ret(prefab_instance_id(0), "Too many prefab instances in the scene");
+
+        auto *inst = new (alloc.memory) prefab_instance_type{ def, transform, alloc };
+        def->instance_count++;
+        place_prefab(inst);
+        return alloc.handle;
+    }
+    void destroy_prefab_instance(prefab_instance_id id)
+    {
+        prefab_instance_type *inst = resolve_prefab(id);
+        if (!inst)
+            return;
+        remove_prefab(inst);
+        const_cast<prefab_type *>(inst->def)->instance_count--;
+        prefab_objects.free(inst->alloc);
+    }
+    // The instance `id` names, or null once it was destroyed. Instances move
+    // when their pool is compacted, so only ids are handed out.
+    prefab_instance_type *resolve_prefab(prefab_instance_id id) const
+    {
+        return (prefab_instance_type *)prefab_objects.resolve(id);
     }
-    void updated_layer(handle obj)
+    void move_prefab_instance(prefab_instance_id id, const matrix2d &transform)
     {
-        if (obj->type == sprite_class::translucents)
+        prefab_instance_type *inst = resolve_prefab(id);
+        if (!inst)
+            return;
+        if (get_coord(position_of(inst->transform)) == get_coord(position_of(transform)))
         {
-            grid_space *space = lookup(obj);
-            space->translucents.sort();
+            inst->transform = transform;
+            lookup(get_coord(position_of(transform)))->prefabs.dirty = true;
         }
         else
         {
-            updated_field(obj);
+            remove_prefab(inst);
+            inst->transform = transform;
+            place_prefab(inst);
         }
     }
+
+    tilemap_type *create_tilemap(const tilemap_params *params)
+    {
+        if (!params->tiles || params->width == 0 || params->height == 0)
+            return errors::set_ret(nullptr, "Tilemap needs a texture array and a non-zero size");
+
+        // Keep tilemaps ordered by layer, they are drawn in this order
+        auto pos = std::upper_bound(tilemaps.begin(), tilemaps.end(), params->layer,
+            [](float layer, const std::unique_ptr<tilemap_type> &map)
+            {
+                return layer < map->layer();
+            });
+        auto iter = tilemaps.emplace(pos, new tilemap_type(params));
+        return iter->get();
+    }
+    void destroy_tilemap(tilemap_type *map)
+    {
+        auto iter = std::find_if(tilemaps.begin(), tilemaps.end(),
+            [map](const std::unique_ptr<tilemap_type> &p) { return p.get() == map; });
+        if (iter != tilemaps.end())
+            tilemaps.erase(iter);
+        visible_tile_batches.clear();
+    }
+    emitter_type *create_emitter(const emitter_params *params)
+    {
+        if (!params->tex || params->max_particles == 0)
+            return errors::set_ret(nullptr, "Emitter needs a texture and a non-zero particle budget");
+
+        auto pos = std::upper_bound(emitters.begin(), emitters.end(), params->layer,
+            [](float layer, const std::unique_ptr<emitter_type> &em)
+            {
+                return layer < em->layer();
+            });
+        auto iter = emitters.emplace(pos, new emitter_type(params));
+        return iter->get();
+    }
+    void destroy_emitter(emitter_type *em)
+    {
+        auto iter = std::find_if(emitters.begin(), emitters.end(),
+            [em](const std::unique_ptr<emitter_type> &p) { return p.get() == em; });
+        if (iter != emitters.end())
+            emitters.erase(iter);
+        visible_particle_batches.clear();
+    }
+    void update_particles(float dt)
+    {
+        for (auto &em : emitters)
+            em->update(dt);
+    }
+
     void updated_field(handle obj)
     {
         auto &space = *lookup(obj);
@@ -304,55 +930,489 @@ public:
         }
     }
 
-private:
-    void place_object(handle obj)
+    bool save_snapshot(const char *path, texture_array *const *arrays, uint32_t array_count)
     {
-        vec2 pos = position_of(obj);
-        coord c = get_coord(pos);
-        grid_space &space = *ensure_space(c);
-        texture_array *tary = rd_get_texture_array(obj->tex);
-        switch (obj->type)
+        flush_mutations();
+        if (!page_in_all())
+            return false;
+
+        namespace fmt = scene_snapshot;
+
+        hashmap<texture_array *, uint32_t> texture_indices;
+        for (uint32_t i = 0; i < array_count; ++i)
+            texture_indices[arrays[i]] = i;
+
+        vec<std::pair<coord, grid_space *>> cells;
+        for (auto &pair : groups)
         {
-            case sprite_class::standard:
+            for (int32_t y = 0; y < group_dim; ++y)
             {
-                auto &group = space.standard.sprites[tary];
-                group.sprites.insert(obj);
-                group.dirty = true;
-                space.standard.active = true;
-                space.active = true;
-                break;
+                for (int32_t x = 0; x < group_dim; ++x)
+                {
+                    grid_space &space = pair.second->spaces[y][x];
+                    if (!space_empty(space))
+                        cells.emplace_back(cell_coord(pair.first, coord{ x, y }), &space);
+                }
             }
+        }
 
-            case sprite_class::statics:
-            {
-                auto &group = space.statics.sprites[tary];
-                group.sprites.insert(obj);
-                group.dirty = true;
-                space.statics.active = true;
-                space.active = true;
-                break;
-            }
+        // First pass only counts, so the cell table can be written up front
+        vec<fmt::cell_entry> cell_table;
+        vec<snapshot_segment> segments;
+        cell_table.reserve(cells.size());
 
-            case sprite_class::translucents:
+        uint64_t offset = fmt::align(sizeof(fmt::header) + cells.size() * sizeof(fmt::cell_entry));
+        for (auto &cell : cells)
+        {
+            segments.clear();
+            gather_segments(*cell.second, segments, false);
+
+            fmt::cell_entry entry = { 0 };
+            entry.x = cell.first.x;
+            entry.y = cell.first.y;
+            entry.segment_count = (uint32_t)segments.size();
+            entry.offset = offset;
+            cell_table.push_back(entry);
+
+            offset += segments.size() * sizeof(fmt::segment_entry);
+            for (auto &seg : segments)
             {
-                space.translucents.sprites.push_back(obj);
-                space.translucents.sort();
-                space.translucents.active = true;
-                space.active = true;
-                break;
+                if (texture_indices.find(seg.tary) == texture_indices.end())
+                    return errors::set_ret(false, "Scene uses a texture array missing from the snapshot texture table");
+                offset = fmt::align(offset) + uint64_t(seg.count) * sizeof(instance);
             }
+            offset = fmt::align(offset);
         }
-    }
-    void remove_object(handle obj)
-    {
-        vec2 pos = position_of(obj);
-        coord c = get_coord(pos);
-        grid_space &space = *ensure_space(c);
-        texture_array *tary = rd_get_texture_array(obj->tex);
-        bool mark_removal = false;
-        switch (obj->type)
+
+        std::unique_ptr<FILE, int(*)(FILE *)> file{ fopen(path, "wb"), &fclose };
+        if (!file)
+            return errors::set_ret(false, "Failed to open scene snapshot for writing");
+
+        fmt::header header = { { 0 } };
+        std::copy(std::begin(fmt::magic), std::end(fmt::magic), header.magic);
+        header.version = fmt::version;
+        header.instance_size = sizeof(instance);
+        header.texture_count = array_count;
+        header.grid_width = grid_size.x;
+        header.grid_height = grid_size.y;
+        header.cell_count = (uint32_t)cell_table.size();
+
+        snapshot_writer out{ file.get(), 0 };
+        if (!out.write(&header, sizeof(header)) ||
+            !out.write(cell_table.data(), cell_table.size() * sizeof(fmt::cell_entry)))
         {
-            case sprite_class::standard:
+            return errors::set_ret(false, "Failed to write scene snapshot");
+        }
+
+        vec<fmt::segment_entry> segment_table;
+        for (size_t i = 0; i < cells.size(); ++i)
+        {
+            segments.clear();
+            gather_segments(*cells[i].second, segments, true);
+
+            uint64_t data_offset = cell_table[i].offset + segments.size() * sizeof(fmt::segment_entry);
+            segment_table.clear();
+            for (auto &seg : segments)
+            {
+                fmt::segment_entry entry = { 0 };
+                entry.texture_index = texture_indices[seg.tary];
+                entry.kind = seg.kind;
+                entry.count = seg.count;
+                entry.data_offset = data_offset = fmt::align(data_offset);
+                segment_table.push_back(entry);
+
+                data_offset += uint64_t(seg.count) * sizeof(instance);
+            }
+
+            if (!out.pad_to(cell_table[i].offset) ||
+                !out.write(segment_table.data(), segment_table.size() * sizeof(fmt::segment_entry)))
+            {
+                return errors::set_ret(false, "Failed to write scene snapshot");
+            }
+
+            for (size_t j = 0; j < segments.size(); ++j)
+            {
+                if (!out.pad_to(segment_table[j].data_offset) ||
+                    !out.write(segments[j].data, segments[j].count * sizeof(instance)))
+                {
+                    return errors::set_ret(false, "Failed to write scene snapshot");
+                }
+            }
+        }
+
+        return true;
+    }
+    bool load_snapshot(const char *path, texture_array *const *arrays, uint32_t array_count)
+    {
+        namespace fmt = scene_snapshot;
+
+        auto file = std::make_shared<mapped_file>();
+        if (!file->open(path))
+            return errors::set_ret(false, "Failed to map scene snapshot");
+        // There is no unloading, a second load would only duplicate sprites
+        if (std::find(loaded_snapshots.begin(), loaded_snapshots.end(), file->id()) != loaded_snapshots.end())
+            return errors::set_ret(false, "Scene snapshot is already loaded");
+
+        const uint8_t *base = file->data();
+        const uint64_t size = file->size();
+
+        if (size < sizeof(fmt::header))
+            return errors::set_ret(false, "Scene snapshot is truncated");
+
+        auto &header = *(const fmt::header *)base;
+        if (!std::equal(std::begin(fmt::magic), std::end(fmt::magic), header.magic))
+            return errors::set_ret(false, "File is not a scene snapshot");
+        if (header.version != fmt::version)
+            return errors::set_ret(false, "Unsupported scene snapshot version");
+        if (header.instance_size != sizeof(instance))
+            return errors::set_ret(false, "Scene snapshot was saved by a backend with a different instance layout");
+        if (header.texture_count > array_count)
+            return errors::set_ret(false, "Scene snapshot references more texture arrays than were provided");
+
+        // Cells are stored by coordinate, so they only line up with a scene
+        // using the same grid
+        if (header.grid_width != grid_size.x || header.grid_height != grid_size.y)
+            return errors::set_ret(false, "Scene snapshot grid size does not match the scene");
+
+        uint64_t table_end = sizeof(fmt::header) + uint64_t(header.cell_count) * sizeof(fmt::cell_entry);
+        if (table_end > size)
+            return errors::set_ret(false, "Scene snapshot is truncated");
+
+        // Validate everything before adopting anything, so a bad file
+        // can't leave the scene half loaded. Offsets come from the file, so
+        // bounds are checked by dividing what's left rather than adding to
+        // the offset, which a crafted one could wrap past the end.
+        auto cells = (const fmt::cell_entry *)(base + sizeof(fmt::header));
+        for (uint32_t i = 0; i < header.cell_count; ++i)
+        {
+            const fmt::cell_entry &cell = cells[i];
+            if (cell.offset < table_end || cell.offset > size ||
+                cell.offset % alignof(fmt::segment_entry) != 0 ||
+                cell.segment_count > (size - cell.offset) / sizeof(fmt::segment_entry))
+            {
+                return errors::set_ret(false, "Scene snapshot has a corrupt cell table");
+            }
+
+            auto segs = (const fmt::segment_entry *)(base + cell.offset);
+            for (uint32_t j = 0; j < cell.segment_count; ++j)
+            {
+                const fmt::segment_entry &seg = segs[j];
+                if (seg.data_offset < table_end || seg.data_offset > size ||
+                    seg.data_offset % alignof(instance) != 0 || seg.count == 0 ||
+                    seg.count > (size - seg.data_offset) / sizeof(instance))
+                {
+                    return errors::set_ret(false, "Scene snapshot has a corrupt segment");
+                }
+                if (seg.kind != fmt::segment_opaque && seg.kind != fmt::segment_translucent)
+                    return errors::set_ret(false, "Scene snapshot has a corrupt segment");
+                if (seg.texture_index >= header.texture_count || !arrays[seg.texture_index])
+                    return errors::set_ret(false, "Scene snapshot references a missing texture array");
+            }
+        }
+
+        for (uint32_t i = 0; i < header.cell_count; ++i)
+        {
+            const fmt::cell_entry &cell = cells[i];
+            auto segs = (const fmt::segment_entry *)(base + cell.offset);
+            if (cell.segment_count == 0)
+                continue;
+
+            grid_space &space = *ensure_space(coord{ cell.x, cell.y });
+            for (uint32_t j = 0; j < cell.segment_count; ++j)
+            {
+                baked_segment seg;
+                seg.tary = arrays[segs[j].texture_index];
+                seg.data = (const instance *)(base + segs[j].data_offset);
+                seg.count = segs[j].count;
+                if (segs[j].kind == fmt::segment_translucent)
+                {
+                    space.translucents.baked.push_back(seg);
+                    space.translucents.dirty = true;
+                    space.translucents.active = true;
+                    continue;
+                }
+
+                space.baked.segments.push_back(seg);
+                space.baked.dirty = true;
+                space.baked.active = true;
+                resident_bytes += uint64_t(seg.count) * sizeof(instance);
+            }
+            clean_groups.erase(group_coord(coord{ cell.x, cell.y }).first);
+            space.active = true;
+        }
+
+        loaded_snapshots.push_back(file->id());
+        snapshots.push_back(std::move(file));
+        return true;
+    }
+
+private:
+    struct snapshot_segment
+    {
+        texture_array *tary;
+        uint32_t kind;
+        uint32_t count;
+        const instance *data = nullptr;
+        vec<instance> owned;
+    };
+    struct snapshot_writer
+    {
+        FILE *file;
+        uint64_t pos;
+
+        bool write(const void *data, size_t len)
+        {
+            if (len && fwrite(data, 1, len, file) != len)
+                return false;
+            pos += len;
+            return true;
+        }
+        bool pad_to(uint64_t offset)
+        {
+            static const uint8_t zeroes[scene_snapshot::data_alignment] = { 0 };
+            while (pos < offset)
+            {
+                size_t n = (size_t)std::min<uint64_t>(offset - pos, sizeof(zeroes));
+                if (!write(zeroes, n))
+                    return false;
+            }
+            return pos == offset;
+        }
+    };
+
+    void gather_segments(grid_space &space, vec<snapshot_segment> &out, bool fill)
+    {
+        auto gather_opaque = [&](opaque_pool &pool)
+        {
+            for (auto &pair : pool.sprites)
+            {
+                snapshot_segment seg;
+                seg.tary = pair.first;
+                seg.kind = scene_snapshot::segment_opaque;
+                seg.count = 0;
+                for (handle sprite : pair.second.sprites)
+                    seg.count += is_drawn(sprite);
+                if (seg.count == 0)
+                    continue;
+
+                if (fill)
+                {
+                    seg.owned.reserve(seg.count);
+                    for (handle sprite : pair.second.sprites)
+                    {
+                        if (is_drawn(sprite))
+                            seg.owned.push_back(sprite->hot);
+                    }
+                }
+                out.push_back(std::move(seg));
+            }
+        };
+
+        gather_opaque(space.standard);
+        gather_opaque(space.statics);
+
+        // Prefabs are saved expanded and come back as baked sprites
+        size_t first_prefab = out.size();
+        for (auto *inst : space.prefabs.instances)
+        {
+            for (auto &part : inst->def->parts)
+            {
+                auto seg = std::find_if(out.begin() + first_prefab, out.end(),
+                    [&part](const snapshot_segment &s) { return s.tary == part.tary; });
+                if (seg == out.end())
+                {
+                    snapshot_segment new_seg;
+                    new_seg.tary = part.tary;
+                    new_seg.kind = scene_snapshot::segment_opaque;
+                    new_seg.count = 0;
+                    out.push_back(std::move(new_seg));
+                    seg = out.end() - 1;
+                }
+
+                seg->count += uint32_t(part.children.size());
+                if (fill)
+                {
+                    for (const instance &child : part.children)
+                        seg->owned.push_back(expand_child(child, inst->transform));
+                }
+            }
+        }
+
+        for (auto &baked : space.baked.segments)
+        {
+            snapshot_segment seg;
+            seg.tary = baked.tary;
+            seg.kind = scene_snapshot::segment_opaque;
+            seg.count = baked.count;
+            seg.data = baked.data;
+            out.push_back(std::move(seg));
+        }
+
+        // Translucents are stored as runs in layer order
+        vec<translucent_item> &items = translucent_scratch;
+        gather_translucents(space.translucents, items);
+        for (size_t i = 0; i < items.size();)
+        {
+            size_t end = i + 1;
+            while (end < items.size() && items[end].first == items[i].first)
+                ++end;
+
+            snapshot_segment seg;
+            seg.tary = items[i].first;
+            seg.kind = scene_snapshot::segment_translucent;
+            seg.count = uint32_t(end - i);
+            if (fill)
+            {
+                seg.owned.reserve(seg.count);
+                for (size_t j = i; j < end; ++j)
+                    seg.owned.push_back(*items[j].second);
+            }
+            out.push_back(std::move(seg));
+            i = end;
+        }
+
+        for (auto &seg : out)
+        {
+            if (!seg.owned.empty())
+                seg.data = seg.owned.data();
+        }
+    }
+
+    // Finds the cells of `count` sprites with one batched group lookup,
+    // creating missing ones, into batch_cells and batch_spaces
+    void locate_objects(const handle *objs, size_t count)
+    {
+        batch_cells.resize(count, coord{ 0, 0 });
+        batch_groups.resize(count, coord{ 0, 0 });
+        batch_found.resize(count);
+        batch_spaces.resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            batch_cells[i] = get_coord(position_of(objs[i]));
+            batch_groups[i] = group_coord(batch_cells[i]).first;
+        }
+        groups.get_batch(batch_groups.data(), count, batch_found.data());
+
+        // Take the group pointers before ensure_space moves the table around
+        for (size_t i = 0; i < count; ++i)
+        {
+            coord local = group_coord(batch_cells[i]).second;
+            batch_spaces[i] = batch_found[i] ? &(*batch_found[i])->spaces[local.y][local.x] : nullptr;
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!batch_spaces[i])
+                batch_spaces[i] = ensure_space(batch_cells[i]);
+        }
+    }
+    void place_objects(const handle *objs, size_t count)
+    {
+        locate_objects(objs, count);
+        for (size_t i = 0; i < count; ++i)
+            place_object(objs[i], *batch_spaces[i]);
+    }
+    void place_object(handle obj)
+    {
+        place_object(obj, *ensure_space(get_coord(position_of(obj))));
+    }
+    void place_object(handle obj, grid_space &space)
+    {
+        texture_array *tary = rd_get_texture_array(obj->tex);
+        switch (obj->type)
+        {
+            case sprite_class::standard:
+            {
+                auto &group = space.standard.sprites[tary];
+                group.sprites.insert(obj);
+                group.dirty = true;
+                space.standard.active = true;
+                space.active = true;
+                break;
+            }
+
+            case sprite_class::statics:
+            {
+                auto &group = space.statics.sprites[tary];
+                group.sprites.insert(obj);
+                group.dirty = true;
+                space.statics.active = true;
+                space.active = true;
+                break;
+            }
+
+            case sprite_class::translucents:
+            {
+                space.translucents.sprites.push_back(obj);
+                space.translucents.sort();
+                space.translucents.active = true;
+                space.active = true;
+                break;
+            }
+        }
+
+        note_tags(space, obj);
+        hidden_count(space, obj) += obj->hidden;
+    }
+    void place_prefab(prefab_instance_type *inst)
+    {
+        grid_space &space = *ensure_space(get_coord(position_of(inst->transform)));
+        inst->cell_index = (uint32_t)space.prefabs.instances.size();
+        space.prefabs.instances.push_back(inst);
+        space.prefabs.dirty = true;
+        space.prefabs.active = true;
+        space.active = true;
+    }
+    // Moves a few instances a frame out of the pool's highest buckets and
+    // into the holes destroyed instances left, so the emptied buckets go
+    // back to the OS. Cells keep pointers to their instances, which follow
+    // through the index each instance keeps into its cell's list.
+    void compact_prefabs()
+    {
+        static_assert(std::is_trivially_copyable<prefab_instance_type>::value,
+            "object_pool::compact moves instances with memcpy");
+        prefab_objects.compact(PREFAB_COMPACT_MOVES, [this](const pool_allocation &alloc)
+        {
+            auto *inst = (prefab_instance_type *)alloc.memory;
+            inst->alloc = alloc;
+
+            auto &instances = lookup(get_coord(position_of(inst->transform)))->prefabs.instances;
+            instances[inst->cell_index] = inst;
+        });
+    }
+    void remove_prefab(prefab_instance_type *inst)
+    {
+        coord c = get_coord(position_of(inst->transform));
+        grid_space &space = *ensure_space(c);
+        auto &instances = space.prefabs.instances;
+        instances[inst->cell_index] = instances.back();
+        instances[inst->cell_index]->cell_index = inst->cell_index;
+        instances.pop_back();
+        space.prefabs.dirty = true;
+
+        if (instances.empty())
+        {
+            space.prefabs.batches.clear();
+            space.prefabs.active = false;
+            if (space_empty(space))
+            {
+                space.active = false;
+                recently_emptied.insert(c);
+            }
+        }
+    }
+    void remove_object(handle obj)
+    {
+        coord c = get_coord(position_of(obj));
+        remove_object(obj, c, *ensure_space(c));
+    }
+    void remove_object(handle obj, coord c, grid_space &space)
+    {
+        texture_array *tary = rd_get_texture_array(obj->tex);
+        bool mark_removal = false;
+        hidden_count(space, obj) -= obj->hidden;
+        switch (obj->type)
+        {
+            case sprite_class::standard:
             {
                 auto &group = space.standard.sprites[tary];
                 group.sprites.erase(obj);
@@ -396,7 +1456,7 @@ private:
                 auto &sprites = space.translucents.sprites;
                 sprites.erase(std::find(sprites.begin(), sprites.end(), obj));
                 space.translucents.dirty = true;
-                if (sprites.empty())
+                if (sprites.empty() && space.translucents.baked.empty())
                 {
                     space.translucents.batches.clear();
                     space.translucents.active = false;
@@ -408,9 +1468,7 @@ private:
 
         if (mark_removal)
         {
-            if (space.standard.sprites.empty() &&
-                space.statics.sprites.empty() &&
-                space.translucents.sprites.empty())
+            if (space_empty(space))
             {
                 space.active = false;
                 recently_emptied.insert(c);
@@ -418,11 +1476,157 @@ private:
         }
     }
 
+    void submit(const mutation &m)
+    {
+        if (threaded)
+            mutations.push(m);
+        else
+            apply(m);
+    }
+    void apply(const mutation &m)
+    {
+        // Stale ids are ignored, the sprite is gone
+        handle obj = resolve(m.id);
+        if (!obj)
+            return;
+
+        switch (m.kind)
+        {
+            case mutation::kind_t::uv:
+                obj->hot.uv0 = m.uv[0];
+                obj->hot.uv1 = m.uv[1];
+                updated_field(obj);
+                break;
+
+            case mutation::kind_t::layer:
+                obj->hot.layer = m.layer;
+                if (obj->type == sprite_class::translucents)
+                    lookup(obj)->translucents.sort();
+                else
+                    updated_field(obj);
+                break;
+
+            case mutation::kind_t::tex:
+                if (obj->type != sprite_class::translucents)
+                {
+                    remove_object(obj);
+                    obj->tex = m.tex;
+                    obj->hot.texture_id = rd_get_texture_index(m.tex);
+                    place_object(obj);
+                }
+                else
+                {
+                    obj->tex = m.tex;
+                    obj->hot.texture_id = rd_get_texture_index(m.tex);
+                    updated_field(obj);
+                }
+                break;
+
+            case mutation::kind_t::transform:
+                if (get_coord(position_of(obj)) == get_coord(position_of(m.transform)))
+                {
+                    obj->hot.transform = m.transform;
+                    updated_field(obj);
+                }
+                else
+                {
+                    remove_object(obj);
+                    obj->hot.transform = m.transform;
+                    place_object(obj);
+                }
+                break;
+
+            case mutation::kind_t::tint:
+                obj->hot.tint = m.tint;
+                updated_field(obj);
+                break;
+
+            case mutation::kind_t::hidden:
+                if (obj->hidden == m.hidden)
+                    break;
+                obj->hidden = m.hidden;
+                hidden_count(*lookup(obj), obj) += m.hidden ? 1 : uint32_t(-1);
+                updated_field(obj);
+                break;
+
+            case mutation::kind_t::tags:
+                if (obj->tags == m.tags)
+                    break;
+                obj->tags = m.tags;
+                note_tags(*lookup(obj), obj);
+                updated_field(obj);
+                break;
+
+            case mutation::kind_t::create:
+            case mutation::kind_t::destroy:
+                assert(false);
+                break;
+        }
+    }
+
+    inline bool is_drawn(handle obj) const
+    {
+        return !obj->hidden && (obj->tags & hidden_tags) == 0;
+    }
+    // Whether a group has to check each sprite's cold fields, most groups
+    // hide nothing and upload every hot record without looking at the rest
+    inline bool must_filter(uint32_t tags_present, uint32_t hidden) const
+    {
+        return hidden != 0 || (tags_present & hidden_tags) != 0;
+    }
+    uint32_t &hidden_count(grid_space &space, handle obj)
+    {
+        switch (obj->type)
+        {
+            case sprite_class::standard:
+                return space.standard.sprites[rd_get_texture_array(obj->tex)].hidden_count;
+            case sprite_class::statics:
+                return space.statics.sprites[rd_get_texture_array(obj->tex)].hidden_count;
+            default:
+                return space.translucents.hidden_count;
+        }
+    }
+    void note_tags(grid_space &space, handle obj)
+    {
+        space.tags_present |= obj->tags;
+        switch (obj->type)
+        {
+            case sprite_class::standard:
+                space.standard.sprites[rd_get_texture_array(obj->tex)].tags_present |= obj->tags;
+                break;
+            case sprite_class::statics:
+                space.statics.sprites[rd_get_texture_array(obj->tex)].tags_present |= obj->tags;
+                break;
+            case sprite_class::translucents:
+                space.translucents.tags_present |= obj->tags;
+                break;
+        }
+    }
+    // Marks the batches whose sprites carry a tag that was shown or hidden
+    // since the space was last prepared
+    void apply_tag_mask(grid_space &space)
+    {
+        uint32_t changed = (space.built_mask ^ hidden_tags) & space.tags_present;
+        space.built_mask = hidden_tags;
+        if (changed == 0)
+            return;
+
+        for (auto &group : space.standard.sprites)
+            if (group.second.tags_present & changed) group.second.dirty = true;
+        for (auto &group : space.statics.sprites)
+            if (group.second.tags_present & changed) group.second.dirty = true;
+        if (space.translucents.tags_present & changed)
+            space.translucents.dirty = true;
+    }
+
     bool prepare_space(device *dev, grid_space *space)
     {
+        apply_tag_mask(*space);
         return
             prepare_opaque(dev, space->standard) &&
             prepare_opaque(dev, space->statics) &&
+            prepare_prefabs(dev, space->prefabs) &&
+            prepare_baked(dev, space->baked) &&
             prepare_translucent(dev, space->translucents);
     }
     bool prepare_opaque(device *dev, opaque_pool &pool)
@@ -434,13 +1638,30 @@ private:
                 auto &sprites = pair.second.sprites;
                 assert(!sprites.empty());
 
+                bool filter = must_filter(pair.second.tags_present, pair.second.hidden_count);
+                uint32_t drawn = uint32_t(sprites.size());
+                if (filter)
+                {
+                    drawn = 0;
+                    for (handle sprite : sprites)
+                        drawn += is_drawn(sprite);
+                }
+
+                if (drawn == 0)
+                {
+                    pool.batches.erase(pair.first);
+                    pair.second.dirty = false;
+                    continue;
+                }
+
                 auto &batch = pool.batches[pair.first];
-                if (!batch.start_upload(dev, (uint32_t)sprites.size()))
+                if (!batch.start_upload(dev, drawn, format))
                     return errors::append_ret(false, "Failed to begin upload of sprite batch");
 
                 for (handle sprite : sprites)
                 {
-                    batch.push(static_cast<instance>(*sprite));
+                    if (!filter || is_drawn(sprite))
+                        batch.push(sprite->hot);
                 }
 
                 if (!batch.finish(dev))
@@ -452,19 +1673,121 @@ private:
 
         return true;
     }
+    // Children are expanded here, so the data each instance keeps is just
+    // its root transform
+    bool prepare_prefabs(device *dev, prefab_pool &pool)
+    {
+        if (!pool.dirty)
+            return true;
+
+        prefab_counts.clear();
+        for (auto *inst : pool.instances)
+        {
+            for (auto &part : inst->def->parts)
+                prefab_counts[part.tary] += uint32_t(part.children.size());
+        }
+
+        for (auto it = pool.batches.begin(); it != pool.batches.end();)
+        {
+            if (prefab_counts.find(it->first) == prefab_counts.end())
+                it = pool.batches.erase(it);
+            else
+                ++it;
+        }
+
+        for (auto &count : prefab_counts)
+        {
+            if (!pool.batches[count.first].start_upload(dev, count.second, format))
+                return errors::append_ret(false, "Failed to begin upload of prefab batch");
+        }
+
+        for (auto *inst : pool.instances)
+        {
+            for (auto &part : inst->def->parts)
+            {
+                auto &batch = pool.batches[part.tary];
+                for (const instance &child : part.children)
+                    batch.push(expand_child(child, inst->transform));
+            }
+        }
+
+        for (auto &batch : pool.batches)
+        {
+            if (!batch.second.finish(dev))
+                return errors::append_ret(false, "Failed to finish upload of prefab batch");
+        }
+
+        pool.dirty = false;
+        return true;
+    }
+    bool prepare_baked(device *dev, baked_pool &pool)
+    {
+        if (!pool.dirty)
+            return true;
+
+        pool.batches.resize(pool.segments.size());
+        for (size_t i = 0; i < pool.segments.size(); ++i)
+        {
+            const baked_segment &seg = pool.segments[i];
+            auto &batch = pool.batches[i];
+            batch.first = seg.tary;
+
+            if (!batch.second.start_upload(dev, seg.count, format))
+                return errors::append_ret(false, "Failed to begin upload of baked sprite batch");
+
+            batch.second.push(seg.data, seg.count);
+
+            if (!batch.second.finish(dev))
+                return errors::append_ret(false, "Failed to finish upload of baked sprite batch");
+        }
+
+        pool.dirty = false;
+        return true;
+    }
+    // Live sprites and snapshot runs of a pool in draw order. Sprites hidden
+    // directly or through a tag are left out, baked instances come after
+    // live sprites on the same layer.
+    void gather_translucents(const translucent_pool &pool, vec<translucent_item> &out)
+    {
+        out.clear();
+        bool filter = must_filter(pool.tags_present, pool.hidden_count);
+        for (handle sprite : pool.sprites)
+        {
+            if (!filter || is_drawn(sprite))
+                out.push_back({ rd_get_texture_array(sprite->tex), &sprite->hot });
+        }
+        size_t live = out.size();
+        for (const baked_segment &seg : pool.baked)
+        {
+            for (uint32_t i = 0; i < seg.count; ++i)
+                out.push_back({ seg.tary, seg.data + i });
+        }
+        if (live == out.size())
+            return;
+
+        auto by_layer = [](const translucent_item &l, const translucent_item &r) -> bool
+        {
+            return l.second->layer < r.second->layer;
+        };
+        std::stable_sort(out.begin() + live, out.end(), by_layer);
+        std::inplace_merge(out.begin(), out.begin() + live, out.end(), by_layer);
+    }
     bool prepare_translucent(device *dev, translucent_pool &pool)
     {
         if (!pool.dirty)
             return true;
 
+        vec<translucent_item> &items = translucent_scratch;
+        gather_translucents(pool, items);
+
         vec<uint32_t> runs;
         runs.reserve(pool.batches.size());
 
         uint32_t run_len = 0;
         texture_array *run_tex = nullptr;
-        for (auto *sprite : pool.sprites)
+        for (const translucent_item &item : items)
         {
-            texture_array *ary = sprite->tex->array;
+            texture_array *ary = item.first;
             if (ary != run_tex)
             {
                 if (run_len > 0)
@@ -475,6 +1798,8 @@ private:
 
             run_len++;
         }
+        if (run_len > 0)
+            runs.push_back(run_len);
 
         uint32_t batch_i = 0;
         ordered_batch old_batches;
@@ -490,14 +1815,14 @@ private:
                 current_inst = std::move(old_batches[batch_i++]);
             }
             
-            current_inst.first = pool.sprites[sprite_i]->tex->array;
+            current_inst.first = items[sprite_i].first;
 
-            if (!current_inst.second.start_upload(dev, run))
+            if (!current_inst.second.start_upload(dev, run, format))
                 return errors::append_ret(false, "Failed to begin upload of sprite batch");
 
             for (uint32_t j = 0; j < run; ++j)
             {
-                current_inst.second.push(static_cast<instance>(*pool.sprites[sprite_i + j]));
+                current_inst.second.push(*items[sprite_i + j].second);
             }
 
             if (!current_inst.second.finish(dev))
@@ -507,6 +1832,7 @@ private:
             sprite_i += run;
         }
 
+        pool.dirty = false;
         return true;
     }
 
@@ -516,7 +1842,7 @@ private:
     }
     inline vec2 position_of(handle obj)
     {
-        return position_of(obj->transform);
+        return position_of(obj->hot.transform);
     }
     inline coord get_coord(vec2 v)
     {
@@ -527,15 +1853,444 @@ private:
     }
     inline std::pair<coord, coord> group_coord(coord c)
     {
-        int32_t xgroup = int32_t(std::floor(c.x / 8.f));
-        int32_t groupx = c.x % 8;
+        int32_t xgroup = sg_details::floor_div(c.x, group_dim);
+        int32_t groupx = c.x - xgroup * group_dim;
 
-        int32_t ygroup = int32_t(std::floor(c.y / 8.f));
-        int32_t groupy = c.y % 8;
+        int32_t ygroup = sg_details::floor_div(c.y, group_dim);
+        int32_t groupy = c.y - ygroup * group_dim;
 
         return std::make_pair(coord{ xgroup, ygroup }, coord{ groupx, groupy });
     }
 
+    inline coord cell_coord(coord group, coord local)
+    {
+        return coord{ group.x * group_dim + local.x, group.y * group_dim + local.y };
+    }
+    struct cell_rect
+    {
+        int32_t minx, miny;
+        int32_t maxx, maxy;
+
+        bool contains(int32_t x, int32_t y) const
+        {
+            return x >= minx && x <= maxx && y >= miny && y <= maxy;
+        }
+    };
+
+    // Cells overlapping a world-space rectangle, plus one cell of margin
+    cell_rect cells_covering(vec2 world_min, vec2 world_max)
+    {
+        coord lo = get_coord(world_min);
+        coord hi = get_coord(world_max);
+        return cell_rect{ lo.x - 1, lo.y - 1, hi.x + 1, hi.y + 1 };
+    }
+
+    void track_camera(vec2 center, vec2 view_extent)
+    {
+        vec2 delta = center - last_camera_center;
+        last_camera_center = center;
+
+        // Jumps of more than a screen are cuts, not motion
+        if (!has_camera_history ||
+            std::abs(delta.x) > view_extent.x ||
+            std::abs(delta.y) > view_extent.y)
+        {
+            camera_velocity = vec2{ 0, 0 };
+            has_camera_history = true;
+            return;
+        }
+
+        camera_velocity = camera_velocity * 0.5f + delta * 0.5f;
+    }
+
+    static uint64_t baked_bytes(const grid_group &group)
+    {
+        uint64_t bytes = 0;
+        for (auto &row : group.spaces)
+        {
+            for (auto &space : row)
+            {
+                for (auto &seg : space.baked.segments)
+                    bytes += uint64_t(seg.count) * sizeof(instance);
+            }
+        }
+        return bytes;
+    }
+    // Keeps the groups around the view resident and pages the farthest
+    // others out while over budget
+    bool stream(const cell_rect &visible)
+    {
+        if (!streamer)
+            return true;
+
+        if (!attach_paged_in())
+            return false;
+
+        coord gmin = group_coord(coord{ visible.minx, visible.miny }).first;
+        coord gmax = group_coord(coord{ visible.maxx, visible.maxy }).first;
+        cell_rect wanted = { gmin.x - 1, gmin.y - 1, gmax.x + 1, gmax.y + 1 };
+
+        for (auto &pair : paged)
+        {
+            if (!pair.second.requested && wanted.contains(pair.first.x, pair.first.y))
+            {
+                streamer->page_in(pair.first);
+                pair.second.requested = true;
+            }
+        }
+
+        if (resident_bytes <= resident_budget)
+            return true;
+
+        // Distances are doubled so the center can sit between two groups
+        int64_t cx = int64_t(gmin.x) + gmax.x, cy = int64_t(gmin.y) + gmax.y;
+        vec<std::pair<int64_t, coord>> candidates;
+        for (auto &pair : groups)
+        {
+            const coord &g = pair.first;
+            if (wanted.contains(g.x, g.y) || paged.find(g) != paged.end())
+                continue;
+            if (baked_bytes(*pair.second) == 0)
+                continue;
+
+            int64_t dx = 2 * int64_t(g.x) - cx, dy = 2 * int64_t(g.y) - cy;
+            candidates.emplace_back(dx * dx + dy * dy, g);
+        }
+        std::sort(candidates.begin(), candidates.end(),
+            [](const std::pair<int64_t, coord> &l, const std::pair<int64_t, coord> &r) { return l.first > r.first; });
+
+        for (auto &candidate : candidates)
+        {
+            if (resident_bytes <= resident_budget)
+                break;
+            page_out_group(candidate.second);
+        }
+        return true;
+    }
+    void page_out_group(coord g)
+    {
+        grid_group &group = *groups.find(g)->second;
+        typename streamer_type::segment_list segs;
+        uint64_t bytes = 0;
+        for (int32_t y = 0; y < group_dim; ++y)
+        {
+            for (int32_t x = 0; x < group_dim; ++x)
+            {
+                grid_space &space = group.spaces[y][x];
+                if (space.baked.segments.empty())
+                    continue;
+
+                for (auto &seg : space.baked.segments)
+                {
+                    segs.push_back({ uint32_t(y * group_dim + x), seg.tary, seg.count, seg.data, seg.storage });
+                    bytes += uint64_t(seg.count) * sizeof(instance);
+                }
+                space.baked.segments.clear();
+                space.baked.batches.clear();
+                space.baked.active = false;
+                space.baked.dirty = true;
+                if (space_empty(space))
+                {
+                    space.active = false;
+                    recently_emptied.insert(cell_coord(g, coord{ x, y }));
+                }
+            }
+        }
+
+        streamer->page_out(g, std::move(segs), clean_groups.find(g) != clean_groups.end());
+        clean_groups.insert(g);
+        paged.emplace(g, paged_group{ bytes, false });
+        resident_bytes -= bytes;
+    }
+    // A group that fails to read back stays paged out and is asked for
+    // again the next time it is wanted
+    bool attach_paged_in()
+    {
+        coord g{ 0, 0 };
+        typename streamer_type::segment_list segs;
+        typename streamer_type::result res;
+        bool ok = true;
+        while (streamer->poll(g, segs, res))
+        {
+            if (res == streamer_type::result::read_failed)
+            {
+                auto it = paged.find(g);
+                if (it != paged.end())
+                {
+                    it->second.requested = false;
+                    ok = false;
+                }
+                continue;
+            }
+
+            for (auto &seg : segs)
+            {
+                grid_space &space = *ensure_space(cell_coord(g, coord{ int32_t(seg.cell % group_dim), int32_t(seg.cell / group_dim) }));
+                baked_segment baked;
+                baked.tary = seg.tary;
+                baked.data = seg.data;
+                baked.count = seg.count;
+                baked.storage = std::move(seg.storage);
+                space.baked.segments.push_back(std::move(baked));
+                space.baked.dirty = true;
+                space.baked.active = true;
+                space.active = true;
+                resident_bytes += uint64_t(seg.count) * sizeof(instance);
+            }
+
+            paged.erase(g);
+            if (res == streamer_type::result::write_failed)
+                clean_groups.erase(g);
+        }
+
+        if (!ok)
+            return errors::set_ret(false, "Failed to read sprites back from the scene page file");
+        return true;
+    }
+    // Synchronously brings every paged out group back
+    bool page_in_all()
+    {
+        if (!streamer)
+            return true;
+
+        for (auto &pair : paged)
+        {
+            if (!pair.second.requested)
+            {
+                streamer->page_in(pair.first);
+                pair.second.requested = true;
+            }
+        }
+        streamer->wait_idle();
+        return attach_paged_in();
+    }
+
+    // Instances a space would upload if it were prepared now
+    static uint32_t pending_uploads(const grid_space &space)
+    {
+        size_t n = 0;
+        for (auto &group : space.standard.sprites)
+            if (group.second.dirty) n += group.second.sprites.size();
+        for (auto &group : space.statics.sprites)
+            if (group.second.dirty) n += group.second.sprites.size();
+        if (space.translucents.dirty)
+        {
+            n += space.translucents.sprites.size();
+            for (auto &seg : space.translucents.baked)
+                n += seg.count;
+        }
+        if (space.prefabs.dirty)
+        {
+            for (auto *inst : space.prefabs.instances)
+                n += inst->def->child_count;
+        }
+        if (space.baked.dirty)
+        {
+            for (auto &seg : space.baked.segments)
+                n += seg.count;
+        }
+        return (uint32_t)n;
+    }
+
+    // Walks the camera rectangle forward along its velocity one frame at a
+    // time and prepares the cells each step uncovers, nearest first, until
+    // the frame's upload budget is spent.
+    bool prefetch(device *dev, const cell_rect &visible, vec2 world_min, vec2 world_max)
+    {
+        if (prefetch_frames == 0 || prefetch_budget == 0)
+            return true;
+        if (camera_velocity.x == 0 && camera_velocity.y == 0)
+            return true;
+
+        uint32_t spent = 0;
+        bool out_of_budget = false;
+        auto visit = [&](int32_t x, int32_t y) -> bool
+        {
+            grid_space *space = lookup(coord{ x, y });
+            if (!space || !space->active)
+                return true;
+
+            apply_tag_mask(*space);
+            uint32_t cost = pending_uploads(*space);
+            if (cost == 0)
+                return true;
+
+            // A cell larger than the whole budget still goes through on an
+            // otherwise idle frame, or it would never be prefetched
+            if (spent + cost > prefetch_budget && spent > 0)
+            {
+                out_of_budget = true;
+                return true;
+            }
+
+            spent += cost;
+            out_of_budget = spent >= prefetch_budget;
+            return prepare_space(dev, space);
+        };
+
+        cell_rect prev = visible;
+        for (uint32_t frame = 1; frame <= prefetch_frames && !out_of_budget; ++frame)
+        {
+            vec2 offset = camera_velocity * float(frame);
+            cell_rect next = cells_covering(world_min + offset, world_max + offset);
+
+            for (int32_t y = next.miny; y <= next.maxy && !out_of_budget; ++y)
+            {
+                for (int32_t x = next.minx; x <= next.maxx && !out_of_budget; ++x)
+                {
+                    if (prev.contains(x, y))
+                    {
+                        // Skip the part of the row already covered
+                        x = prev.maxx;
+                        continue;
+                    }
+                    if (!visit(x, y))
+                        return false;
+                }
+            }
+
+            prev = next;
+        }
+
+        return true;
+    }
+
+    bool rebuild_grid(vec2 new_size)
+    {
+        flush_mutations();
+        if (!page_in_all())
+            return false;
+
+        vec<handle> sprites;
+        vec<prefab_instance_type *> prefabs;
+        vec<translucent_item> baked;
+        vec<translucent_item> baked_translucent;
+        for (auto &pair : groups)
+        {
+            for (auto &row : pair.second->spaces)
+            {
+                for (grid_space &space : row)
+                {
+                    for (auto &group : space.standard.sprites)
+                        sprites.insert(sprites.end(), group.second.sprites.begin(), group.second.sprites.end());
+                    for (auto &group : space.statics.sprites)
+                        sprites.insert(sprites.end(), group.second.sprites.begin(), group.second.sprites.end());
+                    sprites.insert(sprites.end(), space.translucents.sprites.begin(), space.translucents.sprites.end());
+                    prefabs.insert(prefabs.end(), space.prefabs.instances.begin(), space.prefabs.instances.end());
+                    for (auto &seg : space.baked.segments)
+                    {
+                        for (uint32_t i = 0; i < seg.count; ++i)
+                            baked.emplace_back(seg.tary, seg.data + i);
+                    }
+                    for (auto &seg : space.translucents.baked)
+                    {
+                        for (uint32_t i = 0; i < seg.count; ++i)
+                            baked_translucent.emplace_back(seg.tary, seg.data + i);
+                    }
+                }
+            }
+        }
+
+        // Copy the baked instances out before their segments go away.
+        // Only consecutive instances with the same texture array are merged,
+        // so draw order within a cell is kept.
+        using baked_run = std::pair<texture_array *, vec<instance>>;
+        using baked_runs = hashmap<coord, vec<baked_run>>;
+        baked_runs baked_cells;
+        baked_runs translucent_cells;
+        grid_size = new_size;
+        auto split_runs = [this](const vec<translucent_item> &items, baked_runs &cells)
+        {
+            for (auto &item : items)
+            {
+                auto &runs = cells[get_coord(position_of(item.second->transform))];
+                if (runs.empty() || runs.back().first != item.first)
+                    runs.emplace_back(item.first, vec<instance>());
+                runs.back().second.push_back(*item.second);
+            }
+        };
+        split_runs(baked, baked_cells);
+        split_runs(baked_translucent, translucent_cells);
+
+        groups.clear();
+        to_be_rendered_items.clear();
+        previously_rendered.clear();
+        recently_occluded.clear();
+        recently_emptied.clear();
+
+        for (handle obj : sprites)
+            place_object(obj);
+        for (auto *inst : prefabs)
+            place_prefab(inst);
+
+        auto own_runs = [](vec<baked_run> &runs, vec<baked_segment> &out)
+        {
+            for (auto &run : runs)
+            {
+                auto storage = std::make_shared<const vec<instance>>(std::move(run.second));
+                baked_segment seg;
+                seg.tary = run.first;
+                seg.data = storage->data();
+                seg.count = (uint32_t)storage->size();
+                seg.storage = std::move(storage);
+                out.push_back(std::move(seg));
+            }
+        };
+        for (auto &cell : baked_cells)
+        {
+            grid_space &space = *ensure_space(cell.first);
+            own_runs(cell.second, space.baked.segments);
+            space.baked.dirty = true;
+            space.baked.active = true;
+            space.active = true;
+        }
+        for (auto &cell : translucent_cells)
+        {
+            grid_space &space = *ensure_space(cell.first);
+            own_runs(cell.second, space.translucents.baked);
+            space.translucents.dirty = true;
+            space.translucents.active = true;
+            space.active = true;
+        }
+
+        // Nothing points into the snapshots or the page file anymore
+        snapshots.clear();
+        if (streamer)
+        {
+            streamer->forget();
+            clean_groups.clear();
+            resident_bytes = 0;
+            for (auto &pair : groups)
+                resident_bytes += baked_bytes(*pair.second);
+        }
+        return true;
+    }
+    inline static uint32_t space_count(const grid_space &space)
+    {
+        size_t n = space.translucents.sprites.size();
+        for (auto &seg : space.translucents.baked)
+            n += seg.count;
+        for (auto &group : space.standard.sprites)
+            n += group.second.sprites.size();
+        for (auto &group : space.statics.sprites)
+            n += group.second.sprites.size();
+        for (auto &seg : space.baked.segments)
+            n += seg.count;
+        for (auto *inst : space.prefabs.instances)
+            n += inst->def->child_count;
+        return (uint32_t)n;
+    }
+    inline static bool space_empty(const grid_space &space)
+    {
+        return
+            space.standard.sprites.empty() &&
+            space.statics.sprites.empty() &&
+            space.translucents.sprites.empty() &&
+            space.translucents.baked.empty() &&
+            space.prefabs.instances.empty() &&
+            space.baked.segments.empty();
+    }
+
     inline grid_space *lookup(handle h)
     {
         return lookup(get_coord(position_of(h)));
@@ -548,12 +2303,15 @@ private:
         if (iter == groups.end())
             return nullptr;
 
-        return &iter->second.spaces[group.second.y][group.second.x];
+        return &iter->second->spaces[group.second.y][group.second.x];
     }
     inline grid_space *ensure_space(coord c)
     {
         auto group = group_coord(c);
-        return &groups[group.first].spaces[group.second.y][group.second.x];
+        auto &slot = groups[group.first];
+        if (!slot)
+            slot.reset(new grid_group);
+        return &slot->spaces[group.second.y][group.second.x];
     }
     inline grid_space *lookup(vec2 pos)
     {
@@ -566,11 +2324,82 @@ private:
     }
 
     vec2 grid_size;
-    hashmap<coord, grid_group> groups;
+    instance_format format;
+
+    uint32_t hidden_tags;
+
+    vec2 camera_velocity;
+    vec2 last_camera_center;
+    bool has_camera_history;
+    uint32_t prefetch_frames;
+    uint32_t prefetch_budget;
+    // Screen pixels per world unit as of the last prepare_rendering, 0 when
+    // the viewport wasn't known
+    float lod_pixels;
+
+    // Boxed so grid_space pointers survive the table moving entries around
+    hashmap<coord, std::unique_ptr<grid_group>> groups;
     hashset<coord> to_be_rendered_items;
     hashset<coord> previously_rendered;
     hashset<coord> recently_occluded;
     hashset<coord> recently_emptied;
 
-    object_pool_t<object> objects;
+    vec<translucent_item> translucent_scratch;
+
+    bool threaded;
+    mutation_queues<mutation> mutations;
+    vec<mutation> applying;
+    hashset<sprite_id> destroyed;
+
+    // locate_objects results
+    vec<coord> batch_cells;
+    vec<coord> batch_groups;
+    vec<const std::unique_ptr<grid_group> *> batch_found;
+    vec<grid_space *> batch_spaces;
+
+    // Pool counters as of the last two prepare_rendering calls
+    struct pool_frame
+    {
+        uint64_t allocs;
+        uint64_t frees;
+        uint32_t frame_allocs;
+        uint32_t frame_frees;
+    };
+    static void count_pool_frame(pool_frame &frame, const pool_usage &u)
+    {
+        frame.frame_allocs = uint32_t(u.allocs - frame.allocs);
+        frame.frame_frees = uint32_t(u.frees - frame.frees);
+        frame.allocs = u.allocs;
+        frame.frees = u.frees;
+    }
+    pool_frame pool_frames[2] = {};
+
+    vec<std::unique_ptr<prefab_type>> prefab_defs;
+    object_pool_t<prefab_instance_type> prefab_objects;
+    // Instances compact_prefabs moves per frame, each a memcpy and a cell
+    // lookup
+    static const uint32_t PREFAB_COMPACT_MOVES = 256;
+    hashmap<texture_array *, uint32_t> prefab_counts;
+    vec<std::shared_ptr<mapped_file>> snapshots;
+    // Every file loaded so far, kept after regridding drops the mappings
+    vec<mapped_file::identity> loaded_snapshots;
+    vec<std::unique_ptr<tilemap_type>> tilemaps;
+    tile_batches visible_tile_batches;
+    vec<std::unique_ptr<emitter_type>> emitters;
+    particle_batches visible_particle_batches;
+    concurrent_object_pool_t<object> objects;
+
+    // Groups whose baked instances are in the page file
+    struct paged_group
+    {
+        uint64_t bytes;
+        bool requested;
+    };
+    uint64_t resident_budget;
+    uint64_t resident_bytes;
+    hashmap<coord, paged_group> paged;
+    // Groups the page file holds an up-to-date copy of
+    hashset<coord> clean_groups;
+    // Last, so the I/O thread stops before the snapshots it may read go away
+    std::unique_ptr<streamer_type> streamer;
 };
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// On-disk layout of a scene snapshot (rd_save_scene / rd_load_scene).
+//
+// The file is laid out by cell so that a loaded snapshot can be mapped into
+// memory and its instance arrays handed straight to the instance buffers:
+//
+//   header
+//   cell_entry[cell_count]
+//   for each cell: segment_entry[segment_count], then the segment data
+//
+// Segment data is an array of the backend's packed `sprite_instance`, so a
+// snapshot is only valid for backends with the same `instance_size`.
+// Texture arrays are stored as indices into the table given when saving.
+// Only sprites the scene currently draws are saved, hidden ones and ones
+// with a hidden tag are left out.
+namespace scene_snapshot
+{
+    static const char magic[4] = { 'R', 'D', 'S', 'N' };
+    static const uint32_t version = 1;
+    static const size_t data_alignment = 16;
+
+    enum segment_kind : uint32_t
+    {
+        segment_opaque = 0,
+        segment_translucent = 1,
+    };
+
+    struct header
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t instance_size;
+        uint32_t texture_count;
+        float grid_width, grid_height;
+        uint32_t cell_count;
+        uint32_t reserved;
+    };
+
+    struct cell_entry
+    {
+        int32_t x, y;
+        uint32_t segment_count;
+        uint32_t reserved;
+        uint64_t offset;
+    };
+
+    struct segment_entry
+    {
+        uint32_t texture_index;
+        uint32_t kind;
+        uint32_t count;
+        uint32_t reserved;
+        uint64_t data_offset;
+    };
+
+    static_assert(sizeof(header) == 32, "snapshot header must be tightly packed");
+    static_assert(sizeof(cell_entry) == 24, "snapshot cell entry must be tightly packed");
+    static_assert(sizeof(segment_entry) == 24, "snapshot segment entry must be tightly packed");
+
+    inline uint64_t align(uint64_t offset)
+    {
+        return (offset + data_alignment - 1) & ~uint64_t(data_alignment - 1);
+    }
+}
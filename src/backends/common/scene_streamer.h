@@ -0,0 +1,348 @@
+#pragma once
+
+#include "renderer.h"
+#include "sg_details.h"
+#include "hashmap.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Pages the baked instances of whole grid groups out to a scratch file and
+// reads them back on a background thread.
+//
+// The page file holds nothing but raw instance arrays; which group, cell
+// and texture array each array belongs to stays in memory, since the file
+// only lives as long as the scene. A group whose contents haven't changed
+// since it was last written is dropped without writing it again. Jobs run
+// in the order they were queued, so a read always sees the write before it.
+// Space a group no longer uses is handed out again to later writes, so the
+// file stays about as large as what is paged out at once.
+template <typename instance>
+class scene_streamer
+{
+public:
+    using coord = sg_details::coord;
+
+    struct segment
+    {
+        uint32_t cell;          // y * group_dim + x within the group
+        texture_array *tary;
+        uint32_t count;
+        // Written from here; may point into a mapped snapshot
+        const instance *data;
+        // Keeps `data` alive until it has been written, owns it after a read
+        std::shared_ptr<const std::vector<instance>> storage;
+    };
+    using segment_list = std::vector<segment>;
+
+    scene_streamer(const scene_streamer &) = delete;
+    scene_streamer &operator=(const scene_streamer &) = delete;
+
+    scene_streamer() : file(nullptr), stopping(false), busy(false) {}
+    ~scene_streamer()
+    {
+        close();
+    }
+
+    bool open(const char *path)
+    {
+        close();
+        file = fopen(path, "w+b");
+        if (!file)
+            return false;
+
+        file_path = path;
+        file_end = 0;
+        free_extents.clear();
+        stopping = false;
+        worker = std::thread([this] { run(); });
+        return true;
+    }
+    void close()
+    {
+        if (!file)
+            return;
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        worker.join();
+
+        fclose(file);
+        remove(file_path.c_str());
+        file = nullptr;
+        jobs.clear();
+        done.clear();
+        records.clear();
+        free_extents.clear();
+    }
+    bool is_open() const
+    {
+        return file != nullptr;
+    }
+
+    // Queues a group's segments for writing. With `unchanged` set the copy
+    // already in the file is kept and nothing is written.
+    void page_out(coord group, segment_list segs, bool unchanged)
+    {
+        if (unchanged)
+            return;
+        push(job{ job::write, group, std::move(segs), false });
+    }
+    void page_in(coord group)
+    {
+        push(job{ job::read, group, {}, false });
+    }
+    enum class result
+    {
+        // A read finished and `segs` holds the whole group
+        read,
+        // A write failed and hands its segments back; the file has no
+        // copy of the group
+        write_failed,
+        // A read failed and `segs` is empty; the group is still in the
+        // file and can be asked for again
+        read_failed,
+    };
+    // Returns the next group that is done with, if any
+    bool poll(coord &group, segment_list &segs, result &res)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (done.empty())
+            return false;
+
+        group = done.front().group;
+        segs = std::move(done.front().segs);
+        if (done.front().kind == job::write)
+            res = result::write_failed;
+        else
+            res = done.front().failed ? result::read_failed : result::read;
+        done.pop_front();
+        return true;
+    }
+    // Blocks until every queued job has run
+    void wait_idle()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        idle.wait(guard, [this] { return jobs.empty() && !busy; });
+    }
+    // Forgets what the file holds, e.g. after the grid was rebuilt. Its
+    // space is reused by the writes that follow.
+    void forget()
+    {
+        wait_idle();
+        for (auto &pair : records)
+            release(pair.second);
+        records.clear();
+    }
+
+private:
+    struct job
+    {
+        enum kind_t { write, read } kind;
+        coord group;
+        segment_list segs;
+        bool failed;
+    };
+    struct record
+    {
+        uint32_t cell;
+        texture_array *tary;
+        uint32_t count;
+        uint64_t offset;
+    };
+    struct extent
+    {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    void push(job &&j)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            jobs.push_back(std::move(j));
+        }
+        wake.notify_one();
+    }
+
+    void run()
+    {
+        for (;;)
+        {
+            job j{ job::read, coord{ 0, 0 }, {}, false };
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                wake.wait(guard, [this] { return stopping || !jobs.empty(); });
+                if (stopping)
+                    return;
+
+                j = std::move(jobs.front());
+                jobs.pop_front();
+                busy = true;
+            }
+
+            bool hand_back = j.kind == job::read;
+            if (j.kind == job::write)
+                hand_back = !write_group(j);
+            else
+                j.failed = !read_group(j);
+
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (hand_back)
+                    done.push_back(std::move(j));
+                busy = false;
+            }
+            idle.notify_all();
+        }
+    }
+
+    // Only the worker touches the file, `records` and `free_extents` while
+    // it runs
+    bool write_group(job &j)
+    {
+        auto &recs = records[j.group];
+        release(recs);
+        recs.clear();
+        for (const segment &seg : j.segs)
+        {
+            size_t bytes = size_t(seg.count) * sizeof(instance);
+            uint64_t offset = allocate(bytes);
+            if (!fseek64(offset) || fwrite(seg.data, 1, bytes, file) != bytes)
+            {
+                release(recs);
+                records.erase(j.group);
+                free_extent(offset, bytes);
+                return false;
+            }
+
+            recs.push_back(record{ seg.cell, seg.tary, seg.count, offset });
+        }
+        if (fflush(file) != 0)
+        {
+            release(recs);
+            records.erase(j.group);
+            return false;
+        }
+        return true;
+    }
+    // Either reads the whole group or leaves `j.segs` empty
+    bool read_group(job &j)
+    {
+        auto it = records.find(j.group);
+        if (it == records.end())
+            return false;
+
+        for (const record &rec : it->second)
+        {
+            auto storage = std::make_shared<std::vector<instance>>(rec.count);
+            size_t bytes = size_t(rec.count) * sizeof(instance);
+            if (!fseek64(rec.offset) || fread(storage->data(), 1, bytes, file) != bytes)
+            {
+                j.segs.clear();
+                return false;
+            }
+
+            segment seg;
+            seg.cell = rec.cell;
+            seg.tary = rec.tary;
+            seg.count = rec.count;
+            seg.data = storage->data();
+            seg.storage = std::move(storage);
+            j.segs.push_back(std::move(seg));
+        }
+        return true;
+    }
+
+    // First fit from the free list, else the end of the file
+    uint64_t allocate(uint64_t bytes)
+    {
+        for (size_t i = 0; i < free_extents.size(); ++i)
+        {
+            extent &e = free_extents[i];
+            if (e.size < bytes)
+                continue;
+
+            uint64_t offset = e.offset;
+            e.offset += bytes;
+            e.size -= bytes;
+            if (e.size == 0)
+                free_extents.erase(free_extents.begin() + i);
+            return offset;
+        }
+
+        uint64_t offset = file_end;
+        file_end += bytes;
+        return offset;
+    }
+    void release(const std::vector<record> &recs)
+    {
+        for (const record &rec : recs)
+            free_extent(rec.offset, uint64_t(rec.count) * sizeof(instance));
+    }
+    // Keeps `free_extents` sorted and merged, and gives space at the end
+    // back to the file
+    void free_extent(uint64_t offset, uint64_t bytes)
+    {
+        if (bytes == 0)
+            return;
+
+        auto it = std::lower_bound(free_extents.begin(), free_extents.end(), offset,
+            [](const extent &e, uint64_t off) { return e.offset < off; });
+        it = free_extents.insert(it, extent{ offset, bytes });
+        auto next = it + 1;
+        if (next != free_extents.end() && it->offset + it->size == next->offset)
+        {
+            it->size += next->size;
+            free_extents.erase(next);
+        }
+        if (it != free_extents.begin())
+        {
+            auto prev = it - 1;
+            if (prev->offset + prev->size == it->offset)
+            {
+                prev->size += it->size;
+                it = free_extents.erase(it) - 1;
+            }
+        }
+        if (it->offset + it->size == file_end)
+        {
+            file_end = it->offset;
+            free_extents.erase(it);
+        }
+    }
+
+    bool fseek64(uint64_t offset)
+    {
+#ifdef _WIN32
+        return _fseeki64(file, (long long)offset, SEEK_SET) == 0;
+#else
+        return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+    }
+
+    FILE *file;
+    std::string file_path;
+    uint64_t file_end;
+    hashmap<coord, std::vector<record>, HashPolicy::Fast> records;
+    std::vector<extent> free_extents;
+
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::deque<job> jobs;
+    std::deque<job> done;
+    bool stopping;
+    bool busy;
+};
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <stdint.h>
-#include <unordered_map>
+#include "hash.h"
 
 namespace sg_details
 {
@@ -23,24 +23,19 @@ namespace sg_details
     {
         return !(lhs == rhs);
     }
-}
 
-namespace std
-{
-    template <>
-    class hash<sg_details::coord>
+    // Division rounding towards negative infinity, so cells left of and
+    // below the origin land in the right group
+    inline int32_t floor_div(int32_t a, int32_t b)
     {
-    public:
-        typedef sg_details::coord argument_type;
-        typedef std::size_t result_type;
+        int32_t q = a / b;
+        return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+    }
 
-        result_type operator()(const argument_type &key) const
-        {
-            size_t result = 2166136261;
-            const uint8_t *data = (const uint8_t *)&key;
-            for (size_t i = 0; i < sizeof(argument_type); ++i)
-                result = (result * 16777619) ^ data[i];
-            return result;
-        }
-    };
+    template <typename H>
+    inline void hash_apply(const coord &c, H &h)
+    {
+        ::hash_apply(c.x, h);
+        ::hash_apply(c.y, h);
+    }
 }
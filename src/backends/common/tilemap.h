@@ -0,0 +1,169 @@
+#pragma once
+
+#include "renderer.h"
+#include "renderer_math.h"
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// A grid of 16-bit tile indices drawn from a single texture_array.
+//
+// Tiles are stored in 16x16 chunks and only expanded into instances for
+// chunks the camera can see. Editing a tile only marks its own chunk dirty.
+// Tile 0 is empty, tile N draws slice N-1 of the texture array.
+template <typename instance, template <class I> class instance_buffer, typename errors>
+class tilemap_layer
+{
+public:
+    static const uint32_t chunk_dim = 16;
+    using batch = std::pair<texture_array *, instance_buffer<instance>>;
+
+    tilemap_layer(const tilemap_layer &) = delete;
+    tilemap_layer &operator=(const tilemap_layer &) = delete;
+
+    tilemap_layer(const tilemap_params *params)
+        : params(*params),
+          chunks_x((params->width + chunk_dim - 1) / chunk_dim),
+          chunks_y((params->height + chunk_dim - 1) / chunk_dim),
+          chunks(chunks_x * chunks_y)
+    {
+        for (auto &chunk : chunks)
+            chunk.gpu.first = params->tiles;
+    }
+
+    float layer() const
+    {
+        return params.layer;
+    }
+
+    uint16_t get(uint32_t x, uint32_t y) const
+    {
+        if (x >= params.width || y >= params.height)
+            return 0;
+        return chunk_at(x, y).tiles[local_index(x, y)];
+    }
+    void set(uint32_t x, uint32_t y, uint16_t tile)
+    {
+        if (x >= params.width || y >= params.height)
+            return;
+
+        chunk &c = chunk_at(x, y);
+        uint16_t &slot = c.tiles[local_index(x, y)];
+        if (slot == tile)
+            return;
+
+        c.filled += (tile != 0) - (slot != 0);
+        slot = tile;
+        c.dirty = true;
+    }
+    void set_region(uint32_t x, uint32_t y, uint32_t w, uint32_t h, const uint16_t *tiles)
+    {
+        for (uint32_t j = 0; j < h; ++j)
+        {
+            for (uint32_t i = 0; i < w; ++i)
+            {
+                set(x + i, y + j, tiles[j * w + i]);
+            }
+        }
+    }
+
+    // Expands every dirty chunk overlapping the world-space rectangle
+    // and appends the non-empty ones to `out`.
+    bool prepare(device *dev, instance_format format, vec2 world_min, vec2 world_max, std::vector<const batch *> &out)
+    {
+        vec2 lo = (world_min - params.origin) / params.tile_size;
+        vec2 hi = (world_max - params.origin) / params.tile_size;
+
+        int32_t cx0 = std::max(int32_t(std::floor(lo.x / chunk_dim)), 0);
+        int32_t cy0 = std::max(int32_t(std::floor(lo.y / chunk_dim)), 0);
+        int32_t cx1 = std::min(int32_t(std::floor(hi.x / chunk_dim)), int32_t(chunks_x) - 1);
+        int32_t cy1 = std::min(int32_t(std::floor(hi.y / chunk_dim)), int32_t(chunks_y) - 1);
+
+        for (int32_t cy = cy0; cy <= cy1; ++cy)
+        {
+            for (int32_t cx = cx0; cx <= cx1; ++cx)
+            {
+                chunk &c = chunks[cy * chunks_x + cx];
+                if (c.filled == 0)
+                    continue;
+
+                if (c.dirty && !expand(dev, format, c, uint32_t(cx), uint32_t(cy)))
+                    return false;
+
+                out.push_back(&c.gpu);
+            }
+        }
+
+        return true;
+    }
+
+    void invalidate()
+    {
+        for (auto &c : chunks)
+            c.dirty = true;
+    }
+
+private:
+    struct chunk
+    {
+        uint16_t tiles[chunk_dim * chunk_dim] = { 0 };
+        uint32_t filled = 0;
+        bool dirty = true;
+        batch gpu;
+    };
+
+    chunk &chunk_at(uint32_t x, uint32_t y)
+    {
+        return chunks[(y / chunk_dim) * chunks_x + x / chunk_dim];
+    }
+    const chunk &chunk_at(uint32_t x, uint32_t y) const
+    {
+        return chunks[(y / chunk_dim) * chunks_x + x / chunk_dim];
+    }
+    static uint32_t local_index(uint32_t x, uint32_t y)
+    {
+        return (y % chunk_dim) * chunk_dim + x % chunk_dim;
+    }
+
+    bool expand(device *dev, instance_format format, chunk &c, uint32_t cx, uint32_t cy)
+    {
+        auto &buffer = c.gpu.second;
+        if (!buffer.start_upload(dev, c.filled, format))
+            return errors::append_ret(false, "Failed to begin upload of tilemap chunk");
+
+        instance inst;
+        inst.transform = scale(params.tile_size);
+        inst.tint = params.tint;
+        inst.uv0 = vec2{ 0, 0 };
+        inst.uv1 = vec2{ 1, 1 };
+        inst.layer = params.layer;
+
+        for (uint32_t ly = 0; ly < chunk_dim; ++ly)
+        {
+            for (uint32_t lx = 0; lx < chunk_dim; ++lx)
+            {
+                uint16_t tile = c.tiles[ly * chunk_dim + lx];
+                if (tile == 0)
+                    continue;
+
+                vec2 tile_pos = vec2{ float(cx * chunk_dim + lx) + 0.5f, float(cy * chunk_dim + ly) + 0.5f };
+                vec2 center = params.origin + tile_pos * params.tile_size;
+                inst.transform.m31 = center.x;
+                inst.transform.m32 = center.y;
+                inst.texture_id = uint32_t(tile - 1);
+                buffer.push(inst);
+            }
+        }
+
+        if (!buffer.finish(dev))
+            return errors::append_ret(false, "Failed to finish upload of tilemap chunk");
+
+        c.dirty = false;
+        return true;
+    }
+
+    tilemap_params params;
+    uint32_t chunks_x, chunks_y;
+    std::vector<chunk> chunks;
+};
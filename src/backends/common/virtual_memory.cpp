@@ -0,0 +1,144 @@
+#include "pch.h"
+#include "virtual_memory.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined(MADV_HUGEPAGE)
+// Regions that commit this much are worth backing with huge pages
+static const size_t HUGE_PAGE_THRESHOLD = 2 * 1024 * 1024;
+#endif
+
+static size_t page_size()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (size_t)info.dwPageSize;
+#else
+    return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+reserved_region::reserved_region()
+    : base(nullptr), reserved_bytes(0), committed_bytes(0), huge_pages(false)
+{
+}
+
+reserved_region::~reserved_region()
+{
+    release();
+}
+
+bool reserved_region::grow(size_t bytes)
+{
+    if (bytes > reserved_bytes)
+        return false;
+
+    // At least double what's there, so filling the region takes O(log n) commits
+    size_t page = page_size();
+    size_t target = committed_bytes * 2 > bytes ? committed_bytes * 2 : bytes;
+    target = (target + page - 1) / page * page;
+    if (target > reserved_bytes)
+        target = reserved_bytes;
+
+#ifdef _WIN32
+    if (!VirtualAlloc(base + committed_bytes, target - committed_bytes, MEM_COMMIT, PAGE_READWRITE))
+        return false;
+#else
+    if (mprotect(base + committed_bytes, target - committed_bytes, PROT_READ | PROT_WRITE) != 0)
+        return false;
+#if defined(MADV_HUGEPAGE)
+    if (!huge_pages && target >= HUGE_PAGE_THRESHOLD)
+    {
+        madvise(base, reserved_bytes, MADV_HUGEPAGE);
+        huge_pages = true;
+    }
+#endif
+#endif
+
+    committed_bytes = target;
+    return true;
+}
+
+#ifdef _WIN32
+
+bool reserved_region::reserve(size_t capacity)
+{
+    release();
+
+    // Whole pages only, the tail of the last one would be wasted anyway
+    size_t page = page_size();
+    capacity = (capacity + page - 1) / page * page;
+    void *ptr = VirtualAlloc(nullptr, capacity, MEM_RESERVE, PAGE_NOACCESS);
+    if (!ptr)
+        return false;
+
+    base = (uint8_t *)ptr;
+    reserved_bytes = capacity;
+    return true;
+}
+
+void reserved_region::decommit()
+{
+    if (committed_bytes)
+        VirtualFree(base, committed_bytes, MEM_DECOMMIT);
+
+    committed_bytes = 0;
+}
+
+void reserved_region::release()
+{
+    if (base)
+        VirtualFree(base, 0, MEM_RELEASE);
+
+    base = nullptr;
+    reserved_bytes = 0;
+    committed_bytes = 0;
+    huge_pages = false;
+}
+
+#else
+
+bool reserved_region::reserve(size_t capacity)
+{
+    release();
+
+    size_t page = page_size();
+    capacity = (capacity + page - 1) / page * page;
+    void *ptr = mmap(nullptr, capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (ptr == MAP_FAILED)
+        return false;
+
+    base = (uint8_t *)ptr;
+    reserved_bytes = capacity;
+    return true;
+}
+
+void reserved_region::decommit()
+{
+    // Mapping inaccessible pages over the range frees it and makes stray
+    // accesses fault, as after MEM_DECOMMIT
+    if (committed_bytes)
+        mmap(base, committed_bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+
+    committed_bytes = 0;
+    huge_pages = false;
+}
+
+void reserved_region::release()
+{
+    if (base)
+        munmap(base, reserved_bytes);
+
+    base = nullptr;
+    reserved_bytes = 0;
+    committed_bytes = 0;
+    huge_pages = false;
+}
+
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Address space reserved up front and committed from the start as it is
+// needed. Commits grow geometrically, so a region that only ever holds a
+// few objects costs a page or two, while one that fills up still commits
+// in a handful of steps. Committed memory starts out zeroed.
+//
+// Not thread-safe; callers sharing a region serialise commit() themselves.
+class reserved_region
+{
+public:
+    reserved_region();
+    reserved_region(const reserved_region &) = delete;
+    reserved_region &operator=(const reserved_region &) = delete;
+    ~reserved_region();
+
+    bool reserve(size_t capacity);
+    void release();
+    // Gives every committed page back, keeping the reservation. Committing
+    // again later maps fresh zeroed pages.
+    void decommit();
+
+    // Makes sure at least the first `bytes` of the region are usable
+    bool commit(size_t bytes)
+    {
+        return bytes <= committed_bytes || grow(bytes);
+    }
+
+    uint8_t *data() const { return base; }
+    size_t capacity() const { return reserved_bytes; }
+    size_t committed() const { return committed_bytes; }
+
+private:
+    bool grow(size_t bytes);
+
+    uint8_t *base;
+    size_t reserved_bytes;
+    size_t committed_bytes;
+    bool huge_pages;
+};
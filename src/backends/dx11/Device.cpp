@@ -201,25 +201,57 @@ static bool init_shaders(device * dev)
         elem_desc(1, &sprite_instance::layer,        DXGI_FORMAT_R32_FLOAT,          true, "LAYER"),
         elem_desc(1, &sprite_instance::texture_id,   DXGI_FORMAT_R32_UINT,           true, "TEXTURE_ID"),
     };
+    D3D11_INPUT_ELEMENT_DESC packed_input_desc[] =
+    {
+        elem_desc(0, &sprite_vertex::pos, DXGI_FORMAT_R32G32_FLOAT, false, "POSITION"),
+        elem_desc(0, &sprite_vertex::tex, DXGI_FORMAT_R32G32_FLOAT, false, "TEXCOORD", 0),
 
-    auto &vs = baked_shaders["sprite.vs.hlsl"];
-    auto &ps = baked_shaders["sprite.ps.hlsl"];
+        elem_desc(1, &packed_sprite_instance::linear,      DXGI_FORMAT_R16G16B16A16_FLOAT, true, "TRANSFORM", 0),
+        elem_desc(1, &packed_sprite_instance::translation, DXGI_FORMAT_R32G32_FLOAT,       true, "TRANSFORM", 1),
+        elem_desc(1, &packed_sprite_instance::tint,        DXGI_FORMAT_R8G8B8A8_UNORM,     true, "COLOR"),
+        elem_desc(1, &packed_sprite_instance::uv,          DXGI_FORMAT_R16G16B16A16_FLOAT, true, "TEXCOORD", 1),
+        elem_desc(1, &packed_sprite_instance::layer,       DXGI_FORMAT_R16_FLOAT,          true, "LAYER"),
+        elem_desc(1, &packed_sprite_instance::texture_id,  DXGI_FORMAT_R16_UINT,           true, "TEXTURE_ID"),
+    };
+
+    auto vs = baked_shaders.find("sprite.vs.hlsl");
+    auto ps = baked_shaders.find("sprite.ps.hlsl");
+    if (!vs || !ps)
+        return set_error_and_ret(false, "Sprite shaders are missing from the build");
 
     hr = dev->d3d_device->CreateInputLayout(
         sprite_input_desc, ARRAYSIZE(sprite_input_desc),
-        vs.data(), vs.size(), &dev->sprite_il
+        vs->data, vs->size, &dev->sprite_il
     );
     if (FAILED(hr))
         return append_error_and_ret(set_error_and_ret(false, hr), "Failed to create InputLayout");
 
     hr = dev->d3d_device->CreateVertexShader(
-        vs.data(), vs.size(), nullptr, &dev->sprite_vs
+        vs->data, vs->size, nullptr, &dev->sprite_vs
     );
     if (FAILED(hr))
         return append_error_and_ret(set_error_and_ret(false, hr), "Failed to create VertexShader");
 
+    // Builds baked before the packed shader existed go without it, and
+    // scenes drawn with INSTANCE_PACKED fail instead
+    if (auto packed_vs = baked_shaders.find("sprite_packed.vs.hlsl"))
+    {
+        hr = dev->d3d_device->CreateInputLayout(
+            packed_input_desc, ARRAYSIZE(packed_input_desc),
+            packed_vs->data, packed_vs->size, &dev->sprite_packed_il
+        );
+        if (FAILED(hr))
+            return append_error_and_ret(set_error_and_ret(false, hr), "Failed to create packed InputLayout");
+
+        hr = dev->d3d_device->CreateVertexShader(
+            packed_vs->data, packed_vs->size, nullptr, &dev->sprite_packed_vs
+        );
+        if (FAILED(hr))
+            return append_error_and_ret(set_error_and_ret(false, hr), "Failed to create packed VertexShader");
+    }
+
     hr = dev->d3d_device->CreatePixelShader(
-        ps.data(), ps.size(), nullptr, &dev->sprite_ps
+        ps->data, ps->size, nullptr, &dev->sprite_ps
     );
     if (FAILED(hr))
         return append_error_and_ret(set_error_and_ret(false, hr), "Failed to create PixelShader");
@@ -15,6 +15,8 @@ struct device
     com_ptr<ID3D11VertexShader> sprite_vs;
     com_ptr<ID3D11PixelShader> sprite_ps;
     com_ptr<ID3D11InputLayout> sprite_il;
+    com_ptr<ID3D11VertexShader> sprite_packed_vs;
+    com_ptr<ID3D11InputLayout> sprite_packed_il;
     com_ptr<ID3D11Buffer> sprite_quad;
     
     com_ptr<ID3D11RasterizerState> rasterizer;
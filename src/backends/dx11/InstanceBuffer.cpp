@@ -7,11 +7,14 @@ ib_state::ib_state()
     rd_ib_deactivate(*this);
 }
 
-static bool should_resize(uint32_t count, ib_state &state)
+static bool should_resize(uint32_t count, uint32_t isize, ib_state &state)
 {
     if (!state.buffer)
         return true;
 
+    if (state.stride != isize)
+        return true;
+
     if (state.cap < count)
         return true;
 
@@ -30,7 +33,7 @@ bool rd_ib_start_upload(device *dev, uint32_t count, uint32_t isize, ib_state &s
         return set_error_and_ret(false, "Cannot create an instance buffer of size 0");
 
     HRESULT hr;
-    if (should_resize(count, state))
+    if (should_resize(count, isize, state))
     {
         rd_ib_deactivate(state);
         uint32_t new_cap = uint32_t(count * 1.5);
@@ -48,6 +51,7 @@ bool rd_ib_start_upload(device *dev, uint32_t count, uint32_t isize, ib_state &s
             return set_error_and_ret(false, hr);
 
         state.cap = new_cap;
+        state.stride = isize;
     }
 
     memmove(state.previous_counts + 1, state.previous_counts, 7 * sizeof(uint32_t));
@@ -72,6 +76,15 @@ void rd_ib_push(const void *data, uint32_t size, uint32_t count, ib_state &state
     state.idx += count;
 }
 
+void *rd_ib_reserve(uint32_t size, uint32_t count, ib_state &state)
+{
+    assert(state.idx + count <= state.cap);
+    auto dst = ((uint8_t *)state.subres.pData) + size * state.idx;
+
+    state.idx += count;
+    return dst;
+}
+
 bool rd_ib_finish(device *dev, ib_state &state)
 {
     dev->d3d_context->Unmap(state.buffer, 0);
@@ -82,5 +95,6 @@ void rd_ib_deactivate(ib_state &state)
 {
     state.buffer.Release();
     state.cap = 0;
+    state.stride = 0;
     memset(state.previous_counts, 0xFF, sizeof(state.previous_counts));
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "platform.h"
+#include <backends/common/packed_instance.h>
 
 struct ib_state
 {
@@ -8,6 +9,8 @@ struct ib_state
 
     com_ptr<ID3D11Buffer> buffer;
     uint32_t cap;
+    uint32_t stride;
+    instance_format format;
     uint32_t previous_counts[8];
 
     uint32_t idx;
@@ -18,14 +21,16 @@ template <typename T>
 class InstanceBuffer
 {
 public:
-    bool start_upload(device *dev, uint32_t count);
+    bool start_upload(device *dev, uint32_t count, instance_format format = INSTANCE_FULL);
     void push(const T &item);
     void push(const T *data, uint32_t count);
+    T *reserve(uint32_t count);
     bool finish(device *dev);
     void bind(device *dev, UINT slot) const;
 
     void deactivate();
     uint32_t count() const;
+    instance_format format() const;
 
 private:
     ib_state state;
@@ -33,13 +38,15 @@ private:
 
 bool rd_ib_start_upload(device *dev, uint32_t count, uint32_t isize, ib_state &state);
 void rd_ib_push(const void *data, uint32_t size, uint32_t count, ib_state &state);
+void *rd_ib_reserve(uint32_t size, uint32_t count, ib_state &state);
 bool rd_ib_finish(device *dev, ib_state &state);
 void rd_ib_deactivate(ib_state &state);
 
 template<typename T>
-inline bool InstanceBuffer<T>::start_upload(device *dev, uint32_t count)
+inline bool InstanceBuffer<T>::start_upload(device *dev, uint32_t count, instance_format format)
 {
-    return rd_ib_start_upload(dev, count, sizeof(T), state);
+    state.format = format;
+    return rd_ib_start_upload(dev, count, instance_stride(format, sizeof(T)), state);
 }
 
 template<typename T>
@@ -51,9 +58,25 @@ inline void InstanceBuffer<T>::push(const T &item)
 template<typename T>
 inline void InstanceBuffer<T>::push(const T * data, uint32_t count)
 {
+    if (state.format == INSTANCE_PACKED)
+    {
+        // Pack straight into the mapped buffer
+        auto dst = (packed_sprite_instance *)rd_ib_reserve(sizeof(packed_sprite_instance), count, state);
+        for (uint32_t i = 0; i < count; ++i)
+            pack_instance(data[i], dst[i]);
+        return;
+    }
+
     rd_ib_push(data, sizeof(T), count, state);
 }
 
+template<typename T>
+inline T *InstanceBuffer<T>::reserve(uint32_t count)
+{
+    assert(state.format == INSTANCE_FULL);
+    return (T *)rd_ib_reserve(sizeof(T), count, state);
+}
+
 template<typename T>
 inline bool InstanceBuffer<T>::finish(device *dev)
 {
@@ -63,7 +86,7 @@ inline bool InstanceBuffer<T>::finish(device *dev)
 template<typename T>
 inline void InstanceBuffer<T>::bind(device * dev, UINT slot) const
 {
-    UINT strides[] = { sizeof(T) };
+    UINT strides[] = { state.stride };
     UINT offsets[] = { 0 };
     dev->d3d_context->IASetVertexBuffers(slot, 1, &state.buffer.p, strides, offsets);
 }
@@ -74,6 +97,12 @@ inline void InstanceBuffer<T>::deactivate()
     rd_ib_deactivate(state);
 }
 
+template<typename T>
+inline instance_format InstanceBuffer<T>::format() const
+{
+    return state.format;
+}
+
 template<typename T>
 inline uint32_t InstanceBuffer<T>::count() const
 {
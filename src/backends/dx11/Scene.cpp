@@ -16,8 +16,11 @@ void rd_free_scene(scene * scene)
 
 using namespace sg_details;
 using batch_state = decltype(scene::graph)::batch_state;
+using tilemap_type = decltype(scene::graph)::tilemap_type;
+using emitter_type = decltype(scene::graph)::emitter_type;
+using prefab_type = decltype(scene::graph)::prefab_type;
 
-static bool bind_state(device *dev, render_target *rt, camera *cam, const viewport *vp);
+static bool bind_state(device *dev, render_target *rt, camera *cam, const viewport *vp, instance_format format);
 static void bind_sampler(device *dev);
 static void bind_texture(device *dev, texture_array *array);
 static void bind_instance(device *dev, const InstanceBuffer<sprite_instance> &instance);
@@ -25,13 +28,13 @@ static void draw_sprites(device *dev, uint32_t count);
 static thread_local bool was_pixel = false;
 
 template <typename Cont>
-void draw_batch(device *dev, const Cont *cont)
+void draw_batch(device *dev, const scene *scene, const Cont *cont)
 {
     if (cont)
     {
         for (auto &pair : *cont)
         {
-            bind_texture(dev, pair.first);
+            bind_texture(dev, scene->graph.lod_for(pair.first));
             bind_instance(dev, pair.second);
             draw_sprites(dev, pair.second.count());
         }
@@ -40,33 +43,123 @@ void draw_batch(device *dev, const Cont *cont)
 
 bool rd_draw_scene(device * dev, render_target *rt, scene * scene, camera * cam, const viewport * vp)
 {
-    if (!scene->graph.prepare_rendering(dev, cam))
+    if (!scene->graph.prepare_rendering(dev, cam, vp))
         return append_error_and_ret(false, "Error while prepaing scene for drawing");
 
-    if (!bind_state(dev, rt, cam, vp))
+    if (!bind_state(dev, rt, cam, vp, scene->graph.instance_layout()))
         return false;
 
     bind_sampler(dev);
 
+    // Tilemaps are background layers, so they go down first
+    for (auto *tiles : scene->graph.visible_tiles())
+    {
+        bind_texture(dev, scene->graph.lod_for(tiles->first));
+        bind_instance(dev, tiles->second);
+        draw_sprites(dev, tiles->second.count());
+    }
+
     for (const coord &c : scene->graph.to_be_rendered())
     {
         batch_state batch;
         if (!scene->graph.get_batch_state(c, batch))
             continue;
 
-        draw_batch(dev, batch.standard);
-        draw_batch(dev, batch.statics);
-        draw_batch(dev, batch.translucents);
+        draw_batch(dev, scene, batch.standard);
+        draw_batch(dev, scene, batch.statics);
+        draw_batch(dev, scene, batch.prefabs);
+        draw_batch(dev, scene, batch.baked);
+        draw_batch(dev, scene, batch.translucents);
+    }
+
+    for (auto *particles : scene->graph.visible_particles())
+    {
+        bind_texture(dev, scene->graph.lod_for(particles->first));
+        bind_instance(dev, particles->second);
+        draw_sprites(dev, particles->second.count());
     }
 
     return true;
 }
 
-bool bind_state(device *dev, render_target *rt, camera *cam, const viewport *vp)
+void rd_set_scene_prefetch(scene *scene, uint32_t lookahead_frames, uint32_t instance_budget)
+{
+    scene->graph.set_prefetch(lookahead_frames, instance_budget);
+}
+
+bool rd_is_scene_threaded(scene *scene)
+{
+    return scene->graph.is_threaded();
+}
+
+void rd_set_scene_threaded(scene *scene, bool threaded)
+{
+    scene->graph.set_threaded(threaded);
+}
+
+void rd_flush_scene_mutations(scene *scene)
+{
+    scene->graph.flush_mutations();
+}
+
+void rd_get_scene_grid_size(scene *scene, vec2 *size)
+{
+    *size = scene->graph.get_grid_size();
+}
+
+bool rd_set_scene_grid_size(scene *scene, const vec2 *size)
+{
+    return scene->graph.set_grid_size(*size);
+}
+
+bool rd_retune_scene_grid(scene *scene, uint32_t sprites_per_cell)
+{
+    return scene->graph.retune_grid(sprites_per_cell);
+}
+
+instance_format rd_get_scene_instance_format(scene *scene)
+{
+    return scene->graph.instance_layout();
+}
+
+void rd_set_scene_instance_format(scene *scene, instance_format format)
+{
+    scene->graph.set_instance_layout(format);
+}
+
+bool rd_save_scene(scene *scene, const char *path, texture_array *const *arrays, uint32_t array_count)
+{
+    return scene->graph.save_snapshot(path, arrays, array_count);
+}
+
+bool rd_load_scene(scene *scene, const char *path, texture_array *const *arrays, uint32_t array_count)
+{
+    return scene->graph.load_snapshot(path, arrays, array_count);
+}
+
+bool rd_set_scene_streaming(scene *scene, const char *page_file, uint64_t resident_budget)
+{
+    return scene->graph.set_streaming(page_file, resident_budget);
+}
+
+uint64_t rd_get_scene_resident_bytes(scene *scene)
+{
+    return scene->graph.get_resident_bytes();
+}
+
+bool rd_get_scene_pool_stats(scene *scene, scene_pool pool, pool_stats *stats)
+{
+    return scene->graph.get_pool_stats(pool, stats);
+}
+
+bool bind_state(device *dev, render_target *rt, camera *cam, const viewport *vp, instance_format format)
 {
     static const UINT strides[] = { sizeof(sprite_vertex) };
     static const UINT offsets[] = { 0 };
 
+    if (format == INSTANCE_PACKED && !dev->sprite_packed_vs)
+        return set_error_and_ret(false, "Packed instances need sprite_packed.vs.hlsl, which is missing from the build");
+
     D3D11_VIEWPORT view;
     view.TopLeftX = vp->x;
     view.TopLeftY = vp->y;
@@ -82,10 +175,18 @@ bool bind_state(device *dev, render_target *rt, camera *cam, const viewport *vp)
     dev->d3d_context->OMSetBlendState(dev->alpha_blend, nullptr, 0xFFFFFF);
     dev->d3d_context->RSSetState(dev->rasterizer);
     dev->d3d_context->RSSetViewports(1, &view);
-    dev->d3d_context->VSSetShader(dev->sprite_vs, nullptr, 0);
+    if (format == INSTANCE_PACKED)
+    {
+        dev->d3d_context->VSSetShader(dev->sprite_packed_vs, nullptr, 0);
+        dev->d3d_context->IASetInputLayout(dev->sprite_packed_il);
+    }
+    else
+    {
+        dev->d3d_context->VSSetShader(dev->sprite_vs, nullptr, 0);
+        dev->d3d_context->IASetInputLayout(dev->sprite_il);
+    }
     dev->d3d_context->PSSetShader(dev->sprite_ps, nullptr, 0);
     dev->d3d_context->VSSetConstantBuffers(0, 1, cam->cam_buffer.addr());
-    dev->d3d_context->IASetInputLayout(dev->sprite_il);
     dev->d3d_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     dev->d3d_context->IASetVertexBuffers(0, 1, &dev->sprite_quad.p, strides, offsets);
 
@@ -125,6 +226,13 @@ void draw_sprites(device * dev, uint32_t count)
     dev->d3d_context->DrawInstanced(6, count, 0, 0);
 }
 
+static sprite_object *resolve_sprite(scene *scene, sprite_handle sprite)
+{
+    if (sprite_object *obj = scene->graph.resolve(sprite))
+        return obj;
+    return set_error_and_ret("Stale or invalid sprite handle");
+}
+
 sprite_handle rd_create_sprite(scene * scene, const sprite_params * params)
 {
     return scene->graph.create_object(params);
@@ -135,33 +243,45 @@ void rd_destroy_sprite(scene * scene, sprite_handle sprite)
     scene->graph.destroy_object(sprite);
 }
 
-void rd_get_sprite_uv(scene *, sprite_handle sprite, vec2 * topleft, vec2 * bottomright)
+bool rd_create_sprites(scene * scene, const sprite_params * params, uint32_t count, sprite_handle * out)
+{
+    return scene->graph.create_objects(params, count, out);
+}
+
+void rd_destroy_sprites(scene * scene, const sprite_handle * sprites, uint32_t count)
+{
+    scene->graph.destroy_objects(sprites, count);
+}
+
+void rd_get_sprite_uv(scene * scene, sprite_handle sprite, vec2 * topleft, vec2 * bottomright)
 {
-    *topleft = sprite->uv0;
-    *bottomright = sprite->uv1;
+    if (sprite_object *obj = resolve_sprite(scene, sprite))
+    {
+        *topleft = obj->hot.uv0;
+        *bottomright = obj->hot.uv1;
+    }
 }
 
 void rd_set_sprite_uv(scene * scene, sprite_handle sprite, const vec2 * topleft, const vec2 * bottomright)
 {
-    sprite->uv0 = *topleft;
-    sprite->uv1 = *bottomright;
-    scene->graph.updated_field(sprite);
+    scene->graph.set_uv(sprite, *topleft, *bottomright);
 }
 
-float rd_get_sprite_layer(scene *, sprite_handle sprite)
+float rd_get_sprite_layer(scene * scene, sprite_handle sprite)
 {
-    return sprite->layer;
+    sprite_object *obj = resolve_sprite(scene, sprite);
+    return obj ? obj->hot.layer : 0;
 }
 
 void rd_set_sprite_layer(scene * scene, sprite_handle sprite, float layer)
 {
-    sprite->layer = layer;
-    scene->graph.updated_layer(sprite);
+    scene->graph.set_layer(sprite, layer);
 }
 
-texture * rd_get_sprite_texture(scene *, sprite_handle sprite)
+texture * rd_get_sprite_texture(scene * scene, sprite_handle sprite)
 {
-    return sprite->tex;
+    sprite_object *obj = resolve_sprite(scene, sprite);
+    return obj ? obj->tex : nullptr;
 }
 
 void rd_set_sprite_texture(scene * scene, sprite_handle sprite, texture * tex)
@@ -169,9 +289,10 @@ void rd_set_sprite_texture(scene * scene, sprite_handle sprite, texture * tex)
     scene->graph.change_texture(sprite, tex);
 }
 
-void rd_get_sprite_transform(scene *, sprite_handle sprite, matrix2d * transform)
+void rd_get_sprite_transform(scene * scene, sprite_handle sprite, matrix2d * transform)
 {
-    *transform = sprite->transform;
+    if (sprite_object *obj = resolve_sprite(scene, sprite))
+        *transform = obj->hot.transform;
 }
 
 void rd_set_sprite_transform(scene * scene, sprite_handle sprite, const matrix2d * transform)
@@ -179,13 +300,125 @@ void rd_set_sprite_transform(scene * scene, sprite_handle sprite, const matrix2d
     scene->graph.move_object(sprite, *transform);
 }
 
-void rd_get_sprite_tint(scene *, sprite_handle sprite, color * tint)
+void rd_get_sprite_tint(scene * scene, sprite_handle sprite, color * tint)
 {
-    *tint = sprite->tint;
+    if (sprite_object *obj = resolve_sprite(scene, sprite))
+        *tint = obj->hot.tint;
 }
 
 void rd_set_sprite_tint(scene * scene, sprite_handle sprite, const color * tint)
 {
-    sprite->tint = *tint;
-    scene->graph.updated_field(sprite);
+    scene->graph.set_tint(sprite, *tint);
+}
+
+bool rd_is_sprite_hidden(scene * scene, sprite_handle sprite)
+{
+    sprite_object *obj = resolve_sprite(scene, sprite);
+    return obj && obj->hidden;
+}
+
+void rd_set_sprite_hidden(scene * scene, sprite_handle sprite, bool hidden)
+{
+    scene->graph.set_hidden(sprite, hidden);
+}
+
+uint32_t rd_get_sprite_tags(scene * scene, sprite_handle sprite)
+{
+    sprite_object *obj = resolve_sprite(scene, sprite);
+    return obj ? obj->tags : 0;
+}
+
+void rd_set_sprite_tags(scene * scene, sprite_handle sprite, uint32_t tags)
+{
+    scene->graph.set_tags(sprite, tags);
+}
+
+bool rd_is_scene_tag_visible(scene * scene, uint32_t tag)
+{
+    return scene->graph.is_tag_visible(tag);
+}
+
+void rd_set_scene_tag_visible(scene * scene, uint32_t tag, bool visible)
+{
+    scene->graph.set_tag_visible(tag, visible);
+}
+
+tilemap * rd_create_tilemap(scene * scene, const tilemap_params * params)
+{
+    return (tilemap *)scene->graph.create_tilemap(params);
+}
+
+void rd_destroy_tilemap(scene * scene, tilemap * map)
+{
+    scene->graph.destroy_tilemap((tilemap_type *)map);
+}
+
+uint16_t rd_get_tile(scene *, tilemap * map, uint32_t x, uint32_t y)
+{
+    return ((tilemap_type *)map)->get(x, y);
+}
+
+void rd_set_tile(scene *, tilemap * map, uint32_t x, uint32_t y, uint16_t tile)
+{
+    ((tilemap_type *)map)->set(x, y, tile);
+}
+
+void rd_set_tile_region(scene *, tilemap * map, uint32_t x, uint32_t y, uint32_t w, uint32_t h, const uint16_t * tiles)
+{
+    ((tilemap_type *)map)->set_region(x, y, w, h, tiles);
+}
+
+particle_emitter * rd_create_emitter(scene * scene, const emitter_params * params)
+{
+    return (particle_emitter *)scene->graph.create_emitter(params);
+}
+
+void rd_destroy_emitter(scene * scene, particle_emitter * emitter)
+{
+    scene->graph.destroy_emitter((emitter_type *)emitter);
+}
+
+void rd_set_emitter_position(scene *, particle_emitter * emitter, const vec2 * position)
+{
+    ((emitter_type *)emitter)->set_position(*position);
+}
+
+uint32_t rd_get_particle_count(scene *, particle_emitter * emitter)
+{
+    return ((emitter_type *)emitter)->count();
+}
+
+void rd_emit_particles(scene *, particle_emitter * emitter, uint32_t count)
+{
+    ((emitter_type *)emitter)->emit(count);
+}
+
+void rd_update_particles(scene * scene, float dt)
+{
+    scene->graph.update_particles(dt);
+}
+
+prefab * rd_create_prefab(scene * scene, const sprite_params * children, uint32_t count)
+{
+    return (prefab *)scene->graph.create_prefab(children, count);
+}
+
+bool rd_destroy_prefab(scene * scene, prefab * prefab)
+{
+    return scene->graph.destroy_prefab((prefab_type *)prefab);
+}
+
+prefab_instance * rd_instantiate_prefab(scene * scene, prefab * prefab, const matrix2d * transform)
+{
+    return (prefab_instance *)(uintptr_t)scene->graph.instantiate_prefab((prefab_type *)prefab, *transform);
+}
+
+void rd_destroy_prefab_instance(scene * scene, prefab_instance * instance)
+{
+    scene->graph.destroy_prefab_instance((uint32_t)(uintptr_t)instance);
+}
+
+void rd_set_prefab_instance_transform(scene * scene, prefab_instance * instance, const matrix2d * transform)
+{
+    scene->graph.move_prefab_instance((uint32_t)(uintptr_t)instance, *transform);
 }
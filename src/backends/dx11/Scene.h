@@ -19,7 +19,10 @@ struct sprite_instance
     uint32_t texture_id;
 };
 
-struct sprite_object
+// Sprites are split so batching only reads `hot`, which is exactly the
+// instance uploaded to the GPU and starts on its own cache line. The cold
+// half is bookkeeping the scene graph needs when sprites are placed.
+struct alignas(64) sprite_object
 {
     sprite_object(const pool_allocation &alloc, const sprite_params *params)
         : alloc(alloc)
@@ -31,38 +34,39 @@ struct sprite_object
         else
             type = sprite_class::standard;
 
-        transform = params->transform;
-        tint = params->tint;
-        uv0 = params->uv_topleft;
-        uv1 = params->uv_bottomright;
-        layer = params->layer;
+        hot.transform = params->transform;
+        hot.tint = params->tint;
+        hot.uv0 = params->uv_topleft;
+        hot.uv1 = params->uv_bottomright;
+        hot.layer = params->layer;
+        hot.texture_id = params->tex->index;
         tex = params->tex;
+        tags = params->tags;
+        hidden = false;
     }
 
-    matrix2d transform;
-    color tint;
-    vec2 uv0, uv1;
-    float layer;
-    texture *tex;
+    sprite_instance hot;
 
+    texture *tex;
     pool_allocation alloc;
+    uint32_t tags;
     sprite_class type;
-
-    inline explicit operator sprite_instance()
-    {
-        sprite_instance inst;
-        inst.transform = transform;
-        inst.tint = tint;
-        inst.uv0 = uv0;
-        inst.uv1 = uv1;
-        inst.layer = layer;
-        inst.texture_id = tex->index;
-        return inst;
-    }
+    bool hidden;
 };
 
+// Size budgets: one cache line of hot data, at most one of cold data
+static_assert(sizeof(sprite_instance) == 64, "sprite_instance must fill exactly one cache line");
+static_assert(alignof(sprite_object) == 64, "sprites must start on a cache line");
+static_assert(sizeof(sprite_object) <= 128, "cold sprite data must fit in one cache line");
+
 struct error_interface
 {
+    template <typename T>
+    static T set_ret(T ret, const char *msg)
+    {
+        return set_error_and_ret(ret, msg);
+    }
+
     template <typename T>
     static T append_ret(T ret, const char *msg)
     {
@@ -85,8 +89,30 @@ void rd_free_scene(scene *scene);
 
 bool rd_draw_scene(device *dev, render_target *rt, scene *scene, camera *cam, const viewport *vp);
 
+void rd_set_scene_prefetch(scene *scene, uint32_t lookahead_frames, uint32_t instance_budget);
+
+bool rd_is_scene_threaded(scene *scene);
+void rd_set_scene_threaded(scene *scene, bool threaded);
+void rd_flush_scene_mutations(scene *scene);
+
+void rd_get_scene_grid_size(scene *scene, vec2 *size);
+bool rd_set_scene_grid_size(scene *scene, const vec2 *size);
+bool rd_retune_scene_grid(scene *scene, uint32_t sprites_per_cell);
+
+instance_format rd_get_scene_instance_format(scene *scene);
+void rd_set_scene_instance_format(scene *scene, instance_format format);
+
+bool rd_save_scene(scene *scene, const char *path, texture_array *const *arrays, uint32_t array_count);
+bool rd_load_scene(scene *scene, const char *path, texture_array *const *arrays, uint32_t array_count);
+
+bool rd_set_scene_streaming(scene *scene, const char *page_file, uint64_t resident_budget);
+uint64_t rd_get_scene_resident_bytes(scene *scene);
+bool rd_get_scene_pool_stats(scene *scene, scene_pool pool, pool_stats *stats);
+
 sprite_handle rd_create_sprite(scene *scene, const sprite_params *params);
 void rd_destroy_sprite(scene *scene, sprite_handle sprite);
+bool rd_create_sprites(scene *scene, const sprite_params *params, uint32_t count, sprite_handle *out);
+void rd_destroy_sprites(scene *scene, const sprite_handle *sprites, uint32_t count);
 
 void rd_get_sprite_uv(scene *scene, sprite_handle sprite, vec2 *topleft, vec2 *bottomright);
 void rd_set_sprite_uv(scene *scene, sprite_handle sprite, const vec2 *topleft, const vec2 *bottomright);
@@ -102,3 +128,34 @@ void rd_set_sprite_transform(scene *scene, sprite_handle sprite, const matrix2d
 
 void rd_get_sprite_tint(scene *scene, sprite_handle sprite, color *tint);
 void rd_set_sprite_tint(scene *scene, sprite_handle sprite, const color *tint);
+
+bool rd_is_sprite_hidden(scene *scene, sprite_handle sprite);
+void rd_set_sprite_hidden(scene *scene, sprite_handle sprite, bool hidden);
+
+uint32_t rd_get_sprite_tags(scene *scene, sprite_handle sprite);
+void rd_set_sprite_tags(scene *scene, sprite_handle sprite, uint32_t tags);
+
+bool rd_is_scene_tag_visible(scene *scene, uint32_t tag);
+void rd_set_scene_tag_visible(scene *scene, uint32_t tag, bool visible);
+
+tilemap *rd_create_tilemap(scene *scene, const tilemap_params *params);
+void rd_destroy_tilemap(scene *scene, tilemap *map);
+
+uint16_t rd_get_tile(scene *scene, tilemap *map, uint32_t x, uint32_t y);
+void rd_set_tile(scene *scene, tilemap *map, uint32_t x, uint32_t y, uint16_t tile);
+void rd_set_tile_region(scene *scene, tilemap *map, uint32_t x, uint32_t y, uint32_t w, uint32_t h, const uint16_t *tiles);
+
+particle_emitter *rd_create_emitter(scene *scene, const emitter_params *params);
+void rd_destroy_emitter(scene *scene, particle_emitter *emitter);
+
+void rd_set_emitter_position(scene *scene, particle_emitter *emitter, const vec2 *position);
+uint32_t rd_get_particle_count(scene *scene, particle_emitter *emitter);
+void rd_emit_particles(scene *scene, particle_emitter *emitter, uint32_t count);
+void rd_update_particles(scene *scene, float dt);
+
+prefab *rd_create_prefab(scene *scene, const sprite_params *children, uint32_t count);
+bool rd_destroy_prefab(scene *scene, prefab *prefab);
+
+prefab_instance *rd_instantiate_prefab(scene *scene, prefab *prefab, const matrix2d *transform);
+void rd_destroy_prefab_instance(scene *scene, prefab_instance *instance);
+void rd_set_prefab_instance_transform(scene *scene, prefab_instance *instance, const matrix2d *transform);
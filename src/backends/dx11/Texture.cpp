@@ -97,6 +97,33 @@ void rd_set_texture_array_pixel_art(texture_array * set, bool pa)
     set->pixel_art = pa;
 }
 
+bool rd_set_texture_array_lod(texture_array * set, texture_array * lower, float max_pixels_per_unit)
+{
+    if (lower)
+    {
+        if (lower->textures.size() != set->textures.size())
+            return set_error_and_ret(false, "LOD texture array must have the same sprite count");
+        if (lower->width > set->width || lower->height > set->height)
+            return set_error_and_ret(false, "LOD texture array must not be larger than its parent");
+        for (texture_array *it = lower; it; it = it->lod)
+        {
+            if (it == set)
+                return set_error_and_ret(false, "LOD chain would loop");
+        }
+    }
+
+    set->lod = lower;
+    set->lod_max_pixels = max_pixels_per_unit;
+    return true;
+}
+
+texture_array * rd_get_texture_array_lod(const texture_array * set, float * max_pixels_per_unit)
+{
+    if (max_pixels_per_unit)
+        *max_pixels_per_unit = set->lod_max_pixels;
+    return set->lod;
+}
+
 texture * rd_get_texture(texture_array * set, uint32_t index)
 {
     if (index >= set->textures.size())
@@ -110,6 +137,11 @@ texture_array * rd_get_texture_array(texture * texture)
     return texture->array;
 }
 
+uint32_t rd_get_texture_index(texture *texture)
+{
+    return texture->index;
+}
+
 bool rd_update_texture(device *dev, texture *texture, const uint8_t *data, size_t len)
 {
     auto ary = texture->array;
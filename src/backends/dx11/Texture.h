@@ -16,6 +16,8 @@ struct texture_array
     bool streaming;
     bool pixel_art;
     uint32_t width, height;
+    texture_array *lod = nullptr;
+    float lod_max_pixels = 0;
     com_ptr<ID3D11Texture2D> buffer;
     com_ptr<ID3D11ShaderResourceView> srv;
     std::vector<texture> textures;
@@ -29,7 +31,10 @@ uint32_t rd_get_texture_array_count(const texture_array *set);
 bool rd_is_texture_array_streaming(const texture_array *set);
 bool rd_is_texture_array_pixel_art(const texture_array *set);
 void rd_set_texture_array_pixel_art(texture_array *set, bool pa);
+bool rd_set_texture_array_lod(texture_array *set, texture_array *lower, float max_pixels_per_unit);
+texture_array *rd_get_texture_array_lod(const texture_array *set, float *max_pixels_per_unit);
 
 texture *rd_get_texture(texture_array *set, uint32_t index);
 texture_array *rd_get_texture_array(texture *texture);
+uint32_t rd_get_texture_index(texture *texture);
 bool rd_update_texture(device *dev, texture *texture, const uint8_t *data, size_t len);
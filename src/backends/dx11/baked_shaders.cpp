@@ -1,10 +1,180 @@
 #include "pch.h"
-#include <unordered_map>
-#include <string>
-using namespace std::string_literals;
-
-std::unordered_map<std::string, std::string> baked_shaders =
-std::unordered_map<std::string, std::string> {
-{"sprite.ps.hlsl"s,"\x44\x58\x42\x43\xEB\xD7\xD6\xBF\xFF\xEF\xE7\x58\x52\xDA\xC2\x16\x57\x90\x00\xD4\x01\x00\x00\x00\x40\x03\x00\x00\x05\x00\x00\x00\x34\x00\x00\x00\xFC\x00\x00\x00\x94\x01\x00\x00\xC8\x01\x00\x00\xA4\x02\x00\x00\x52\x44\x45\x46\xC0\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x02\x00\x00\x00\x3C\x00\x00\x00\x00\x05\xFF\xFF\x00\x01\x00\x00\x96\x00\x00\x00\x52\x44\x31\x31\x3C\x00\x00\x00\x18\x00\x00\x00\x20\x00\x00\x00\x28\x00\x00\x00\x24\x00\x00\x00\x0C\x00\x00\x00\x00\x00\x00\x00\x7C\x00\x00\x00\x03\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x01\x00\x00\x00\x01\x00\x00\x00\x8A\x00\x00\x00\x02\x00\x00\x00\x05\x00\x00\x00\x05\x00\x00\x00\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x01\x00\x00\x00\x0D\x00\x00\x00\x73\x70\x72\x69\x74\x65\x53\x61\x6D\x70\x6C\x65\x72\x00\x73\x70\x72\x69\x74\x65\x53\x68\x65\x65\x74\x00\x4D\x69\x63\x72\x6F\x73\x6F\x66\x74\x20\x28\x52\x29\x20\x48\x4C\x53\x4C\x20\x53\x68\x61\x64\x65\x72\x20\x43\x6F\x6D\x70\x69\x6C\x65\x72\x20\x31\x30\x2E\x31\x00\xAB\xAB\x49\x53\x47\x4E\x90\x00\x00\x00\x04\x00\x00\x00\x08\x00\x00\x00\x68\x00\x00\x00\x00\x00\x00\x00\x01\x00\x00\x00\x03\x00\x00\x00\x00\x00\x00\x00\x0F\x00\x00\x00\x74\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x03\x00\x00\x00\x01\x00\x00\x00\x0F\x0F\x00\x00\x7A\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x03\x00\x00\x00\x02\x00\x00\x00\x03\x03\x00\x00\x83\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x01\x00\x00\x00\x03\x00\x00\x00\x01\x01\x00\x00\x53\x56\x5F\x50\x4F\x53\x49\x54\x49\x4F\x4E\x00\x43\x4F\x4C\x4F\x52\x00\x54\x45\x58\x43\x4F\x4F\x52\x44\x00\x54\x45\x58\x54\x55\x52\x45\x5F\x49\x44\x00\xAB\xAB\x4F\x53\x47\x4E\x2C\x00\x00\x00\x01\x00\x00\x00\x08\x00\x00\x00\x20\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x03\x00\x00\x00\x00\x00\x00\x00\x0F\x00\x00\x00\x53\x56\x5F\x54\x41\x52\x47\x45\x54\x00\xAB\xAB\x53\x48\x45\x58\xD4\x00\x00\x00\x50\x00\x00\x00\x35\x00\x00\x00\x6A\x08\x00\x01\x5A\x00\x00\x03\x00\x60\x10\x00\x00\x00\x00\x00\x58\x40\x00\x04\x00\x70\x10\x00\x00\x00\x00\x00\x55\x55\x00\x00\x62\x10\x00\x03\xF2\x10\x10\x00\x01\x00\x00\x00\x62\x10\x00\x03\x32\x10\x10\x00\x02\x00\x00\x00\x62\x08\x00\x03\x12\x10\x10\x00\x03\x00\x00\x00\x65\x00\x00\x03\xF2\x20\x10\x00\x00\x00\x00\x00\x68\x00\x00\x02\x01\x00\x00\x00\x56\x00\x00\x05\x42\x00\x10\x00\x00\x00\x00\x00\x0A\x10\x10\x00\x03\x00\x00\x00\x36\x00\x00\x05\x32\x00\x10\x00\x00\x00\x00\x00\x46\x10\x10\x00\x02\x00\x00\x00\x45\x00\x00\x8B\x02\x02\x00\x80\x43\x55\x15\x00\xF2\x00\x10\x00\x00\x00\x00\x00\x46\x02\x10\x00\x00\x00\x00\x00\x46\x7E\x10\x00\x00\x00\x00\x00\x00\x60\x10\x00\x00\x00\x00\x00\x38\x00\x00\x07\xF2\x20\x10\x00\x00\x00\x00\x00\x46\x0E\x10\x00\x00\x00\x00\x00\x46\x1E\x10\x00\x01\x00\x00\x00\x3E\x00\x00\x01\x53\x54\x41\x54\x94\x00\x00\x00\x05\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00\x00\x04\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"s},
-{"sprite.vs.hlsl"s,"\x44\x58\x42\x43\x18\x8D\x95\xB2\x18\x5C\x8C\xA5\x93\x20\x07\x4A\x24\xF1\x9F\xEB\x01\x00\x00\x00\xA4\x06\x00\x00\x05\x00\x00\x00\x34\x00\x00\x00\x9C\x01\x00\x00\xD0\x02\x00\x00\x68\x03\x00\x00\x08\x06\x00\x00\x52\x44\x45\x46\x60\x01\x00\x00\x01\x00\x00\x00\x64\x00\x00\x00\x01\x00\x00\x00\x3C\x00\x00\x00\x00\x05\xFE\xFF\x00\x01\x00\x00\x38\x01\x00\x00\x52\x44\x31\x31\x3C\x00\x00\x00\x18\x00\x00\x00\x20\x00\x00\x00\x28\x00\x00\x00\x24\x00\x00\x00\x0C\x00\x00\x00\x00\x00\x00\x00\x5C\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x01\x00\x00\x00\x01\x00\x00\x00\x43\x61\x6D\x65\x72\x61\x00\xAB\x5C\x00\x00\x00\x03\x00\x00\x00\x7C\x00\x00\x00\x20\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xF4\x00\x00\x00\x00\x00\x00\x00\x08\x00\x00\x00\x02\x00\x00\x00\x04\x01\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x28\x01\x00\x00\x08\x00\x00\x00\x08\x00\x00\x00\x02\x00\x00\x00\x04\x01\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x30\x01\x00\x00\x10\x00\x00\x00\x08\x00\x00\x00\x02\x00\x00\x00\x04\x01\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x63\x61\x6D\x65\x72\x61\x30\x00\x66\x6C\x6F\x61\x74\x32\x00\xAB\x01\x00\x03\x00\x01\x00\x02\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFC\x00\x00\x00\x63\x61\x6D\x65\x72\x61\x31\x00\x63\x61\x6D\x65\x72\x61\x32\x00\x4D\x69\x63\x72\x6F\x73\x6F\x66\x74\x20\x28\x52\x29\x20\x48\x4C\x53\x4C\x20\x53\x68\x61\x64\x65\x72\x20\x43\x6F\x6D\x70\x69\x6C\x65\x72\x20\x31\x30\x2E\x31\x00\x49\x53\x47\x4E\x2C\x01\x00\x00\x0A\x00\x00\x00\x08\x00\x00\x00\xF8\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x03\x00\x00\x00\x00\x00\x00\x00\x03\x03\x00\x00\x01\x01\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x03\x00\x00\x00\x01\x00\x00\x00\x03\x03\x00\x00\x0A\x01\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x03\x00\x00\x00\x02\x00\x00\x00\x03\x03\x00\x00\x0A\x01\x00\x00\x01\x00\x00\x00\x00\x00\x00\x00\x03\x00\x00\x00\x03\x00\x00\x00\x03\x03\x00\x00\x0A\x01\x00\x00\x02\x00\x00\x00\x00\x00\x00\x00\x03\x00\x00\x00\x04\x00\x00\x00\x03\x03\x00\x00\x14\x01\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x03\x00\x00\x00\x05\x00\x00\x00\x0F\x0F\x00\x00\x01\x01\x00\x00\x01\x00\x00\x00\x00\x00\x00\x00\x03\x00\x00\x00\x06\x00\x00\x00\x03\x03\x00\x00\x01\x01\x00\x00\x02\x00\x00\x00\x00\x00\x00\x00\x03\x00\x00\x00\x07\x00\x00\x00\x03\x03\x00\x00\x1A\x01\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x03\x00\x00\x00\x08\x00\x00\x00\x01\x00\x00\x00\x20\x01\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x01\x00\x00\x00\x09\x00\x00\x00\x01\x01\x00\x00\x50\x4F\x53\x49\x54\x49\x4F\x4E\x00\x54\x45\x58\x43\x4F\x4F\x52\x44\x00\x54\x52\x41\x4E\x53\x46\x4F\x52\x4D\x00\x43\x4F\x4C\x4F\x52\x00\x4C\x41\x59\x45\x52\x00\x54\x45\x58\x54\x55\x52\x45\x5F\x49\x44\x00\xAB\x4F\x53\x47\x4E\x90\x00\x00\x00\x04\x00\x00\x00\x08\x00\x00\x00\x68\x00\x00\x00\x00\x00\x00\x00\x01\x00\x00\x00\x03\x00\x00\x00\x00\x00\x00\x00\x0F\x00\x00\x00\x74\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x03\x00\x00\x00\x01\x00\x00\x00\x0F\x00\x00\x00\x7A\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x03\x00\x00\x00\x02\x00\x00\x00\x03\x0C\x00\x00\x83\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x01\x00\x00\x00\x03\x00\x00\x00\x01\x0E\x00\x00\x53\x56\x5F\x50\x4F\x53\x49\x54\x49\x4F\x4E\x00\x43\x4F\x4C\x4F\x52\x00\x54\x45\x58\x43\x4F\x4F\x52\x44\x00\x54\x45\x58\x54\x55\x52\x45\x5F\x49\x44\x00\xAB\xAB\x53\x48\x45\x58\x98\x02\x00\x00\x50\x00\x01\x00\xA6\x00\x00\x00\x6A\x08\x00\x01\x59\x00\x00\x04\x46\x8E\x20\x00\x00\x00\x00\x00\x02\x00\x00\x00\x5F\x00\x00\x03\x32\x10\x10\x00\x00\x00\x00\x00\x5F\x00\x00\x03\x32\x10\x10\x00\x01\x00\x00\x00\x5F\x00\x00\x03\x32\x10\x10\x00\x02\x00\x00\x00\x5F\x00\x00\x03\x32\x10\x10\x00\x03\x00\x00\x00\x5F\x00\x00\x03\x32\x10\x10\x00\x04\x00\x00\x00\x5F\x00\x00\x03\xF2\x10\x10\x00\x05\x00\x00\x00\x5F\x00\x00\x03\x32\x10\x10\x00\x06\x00\x00\x00\x5F\x00\x00\x03\x32\x10\x10\x00\x07\x00\x00\x00\x5F\x00\x00\x03\x12\x10\x10\x00\x09\x00\x00\x00\x67\x00\x00\x04\xF2\x20\x10\x00\x00\x00\x00\x00\x01\x00\x00\x00\x65\x00\x00\x03\xF2\x20\x10\x00\x01\x00\x00\x00\x65\x00\x00\x03\x32\x20\x10\x00\x02\x00\x00\x00\x65\x00\x00\x03\x12\x20\x10\x00\x03\x00\x00\x00\x68\x00\x00\x02\x02\x00\x00\x00\x36\x00\x00\x05\x32\x00\x10\x00\x00\x00\x00\x00\x46\x10\x10\x00\x00\x00\x00\x00\x36\x00\x00\x05\x42\x00\x10\x00\x00\x00\x00\x00\x01\x40\x00\x00\x00\x00\x80\x3F\x36\x00\x00\x05\x32\x00\x10\x00\x01\x00\x00\x00\x46\x10\x10\x00\x04\x00\x00\x00\x36\x00\x00\x05\x42\x00\x10\x00\x01\x00\x00\x00\x01\x40\x00\x00\x00\x00\x80\x3F\x10\x00\x00\x07\x42\x00\x10\x00\x00\x00\x00\x00\x46\x02\x10\x00\x00\x00\x00\x00\x46\x02\x10\x00\x01\x00\x00\x00\x36\x00\x00\x06\x32\x00\x10\x00\x01\x00\x00\x00\x46\x80\x20\x00\x00\x00\x00\x00\x01\x00\x00\x00\x36\x00\x00\x05\x42\x00\x10\x00\x01\x00\x00\x00\x01\x40\x00\x00\x00\x00\x80\x3F\x0F\x00\x00\x07\x12\x00\x10\x00\x00\x00\x00\x00\x46\x10\x10\x00\x00\x00\x00\x00\x46\x10\x10\x00\x02\x00\x00\x00\x0F\x00\x00\x07\x22\x00\x10\x00\x00\x00\x00\x00\x46\x10\x10\x00\x00\x00\x00\x00\x46\x10\x10\x00\x03\x00\x00\x00\x10\x00\x00\x07\x42\x00\x10\x00\x00\x00\x00\x00\x46\x02\x10\x00\x00\x00\x00\x00\x46\x02\x10\x00\x01\x00\x00\x00\x32\x00\x00\x09\x42\x20\x10\x00\x00\x00\x00\x00\x2A\x00\x10\x00\x00\x00\x00\x00\x01\x40\x00\x00\x6F\x12\x03\x3A\x01\x40\x00\x00\x00\x00\x00\x3F\x36\x00\x00\x05\x82\x20\x10\x00\x00\x00\x00\x00\x01\x40\x00\x00\x00\x00\x80\x3F\x0F\x00\x00\x08\x12\x20\x10\x00\x00\x00\x00\x00\x46\x00\x10\x00\x00\x00\x00\x00\x46\x80\x20\x00\x00\x00\x00\x00\x00\x00\x00\x00\x0F\x00\x00\x08\x22\x20\x10\x00\x00\x00\x00\x00\x46\x00\x10\x00\x00\x00\x00\x00\xE6\x8A\x20\x00\x00\x00\x00\x00\x00\x00\x00\x00\x36\x00\x00\x05\xF2\x20\x10\x00\x01\x00\x00\x00\x46\x1E\x10\x00\x05\x00\x00\x00\x00\x00\x00\x08\x32\x00\x10\x00\x00\x00\x00\x00\x46\x10\x10\x80\x41\x00\x00\x00\x06\x00\x00\x00\x46\x10\x10\x00\x07\x00\x00\x00\x32\x00\x00\x09\x32\x20\x10\x00\x02\x00\x00\x00\x46\x10\x10\x00\x01\x00\x00\x00\x46\x00\x10\x00\x00\x00\x00\x00\x46\x10\x10\x00\x06\x00\x00\x00\x36\x00\x00\x05\x12\x20\x10\x00\x03\x00\x00\x00\x0A\x10\x10\x00\x09\x00\x00\x00\x3E\x00\x00\x01\x53\x54\x41\x54\x94\x00\x00\x00\x13\x00\x00\x00\x02\x00\x00\x00\x00\x00\x00\x00\x0D\x00\x00\x00\x09\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x09\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"s},
+#include <backends/common/baked_shaders.h>
+
+static const uint8_t baked_shaders_1[] = {
+0x44,0x58,0x42,0x43,0xEB,0xD7,0xD6,0xBF,0xFF,0xEF,0xE7,0x58,0x52,0xDA,0xC2,0x16,
+0x57,0x90,0x00,0xD4,0x01,0x00,0x00,0x00,0x40,0x03,0x00,0x00,0x05,0x00,0x00,0x00,
+0x34,0x00,0x00,0x00,0xFC,0x00,0x00,0x00,0x94,0x01,0x00,0x00,0xC8,0x01,0x00,0x00,
+0xA4,0x02,0x00,0x00,0x52,0x44,0x45,0x46,0xC0,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x3C,0x00,0x00,0x00,0x00,0x05,0xFF,0xFF,
+0x00,0x01,0x00,0x00,0x96,0x00,0x00,0x00,0x52,0x44,0x31,0x31,0x3C,0x00,0x00,0x00,
+0x18,0x00,0x00,0x00,0x20,0x00,0x00,0x00,0x28,0x00,0x00,0x00,0x24,0x00,0x00,0x00,
+0x0C,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x7C,0x00,0x00,0x00,0x03,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x01,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x8A,0x00,0x00,0x00,0x02,0x00,0x00,0x00,
+0x05,0x00,0x00,0x00,0x05,0x00,0x00,0x00,0xFF,0xFF,0xFF,0xFF,0x00,0x00,0x00,0x00,
+0x01,0x00,0x00,0x00,0x0D,0x00,0x00,0x00,0x73,0x70,0x72,0x69,0x74,0x65,0x53,0x61,
+0x6D,0x70,0x6C,0x65,0x72,0x00,0x73,0x70,0x72,0x69,0x74,0x65,0x53,0x68,0x65,0x65,
+0x74,0x00,0x4D,0x69,0x63,0x72,0x6F,0x73,0x6F,0x66,0x74,0x20,0x28,0x52,0x29,0x20,
+0x48,0x4C,0x53,0x4C,0x20,0x53,0x68,0x61,0x64,0x65,0x72,0x20,0x43,0x6F,0x6D,0x70,
+0x69,0x6C,0x65,0x72,0x20,0x31,0x30,0x2E,0x31,0x00,0xAB,0xAB,0x49,0x53,0x47,0x4E,
+0x90,0x00,0x00,0x00,0x04,0x00,0x00,0x00,0x08,0x00,0x00,0x00,0x68,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x0F,0x00,0x00,0x00,0x74,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x03,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x0F,0x0F,0x00,0x00,0x7A,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x02,0x00,0x00,0x00,
+0x03,0x03,0x00,0x00,0x83,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x01,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x01,0x01,0x00,0x00,0x53,0x56,0x5F,0x50,
+0x4F,0x53,0x49,0x54,0x49,0x4F,0x4E,0x00,0x43,0x4F,0x4C,0x4F,0x52,0x00,0x54,0x45,
+0x58,0x43,0x4F,0x4F,0x52,0x44,0x00,0x54,0x45,0x58,0x54,0x55,0x52,0x45,0x5F,0x49,
+0x44,0x00,0xAB,0xAB,0x4F,0x53,0x47,0x4E,0x2C,0x00,0x00,0x00,0x01,0x00,0x00,0x00,
+0x08,0x00,0x00,0x00,0x20,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x0F,0x00,0x00,0x00,0x53,0x56,0x5F,0x54,
+0x41,0x52,0x47,0x45,0x54,0x00,0xAB,0xAB,0x53,0x48,0x45,0x58,0xD4,0x00,0x00,0x00,
+0x50,0x00,0x00,0x00,0x35,0x00,0x00,0x00,0x6A,0x08,0x00,0x01,0x5A,0x00,0x00,0x03,
+0x00,0x60,0x10,0x00,0x00,0x00,0x00,0x00,0x58,0x40,0x00,0x04,0x00,0x70,0x10,0x00,
+0x00,0x00,0x00,0x00,0x55,0x55,0x00,0x00,0x62,0x10,0x00,0x03,0xF2,0x10,0x10,0x00,
+0x01,0x00,0x00,0x00,0x62,0x10,0x00,0x03,0x32,0x10,0x10,0x00,0x02,0x00,0x00,0x00,
+0x62,0x08,0x00,0x03,0x12,0x10,0x10,0x00,0x03,0x00,0x00,0x00,0x65,0x00,0x00,0x03,
+0xF2,0x20,0x10,0x00,0x00,0x00,0x00,0x00,0x68,0x00,0x00,0x02,0x01,0x00,0x00,0x00,
+0x56,0x00,0x00,0x05,0x42,0x00,0x10,0x00,0x00,0x00,0x00,0x00,0x0A,0x10,0x10,0x00,
+0x03,0x00,0x00,0x00,0x36,0x00,0x00,0x05,0x32,0x00,0x10,0x00,0x00,0x00,0x00,0x00,
+0x46,0x10,0x10,0x00,0x02,0x00,0x00,0x00,0x45,0x00,0x00,0x8B,0x02,0x02,0x00,0x80,
+0x43,0x55,0x15,0x00,0xF2,0x00,0x10,0x00,0x00,0x00,0x00,0x00,0x46,0x02,0x10,0x00,
+0x00,0x00,0x00,0x00,0x46,0x7E,0x10,0x00,0x00,0x00,0x00,0x00,0x00,0x60,0x10,0x00,
+0x00,0x00,0x00,0x00,0x38,0x00,0x00,0x07,0xF2,0x20,0x10,0x00,0x00,0x00,0x00,0x00,
+0x46,0x0E,0x10,0x00,0x00,0x00,0x00,0x00,0x46,0x1E,0x10,0x00,0x01,0x00,0x00,0x00,
+0x3E,0x00,0x00,0x01,0x53,0x54,0x41,0x54,0x94,0x00,0x00,0x00,0x05,0x00,0x00,0x00,
+0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x04,0x00,0x00,0x00,0x01,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+};
+static const uint8_t baked_shaders_2[] = {
+0x44,0x58,0x42,0x43,0x18,0x8D,0x95,0xB2,0x18,0x5C,0x8C,0xA5,0x93,0x20,0x07,0x4A,
+0x24,0xF1,0x9F,0xEB,0x01,0x00,0x00,0x00,0xA4,0x06,0x00,0x00,0x05,0x00,0x00,0x00,
+0x34,0x00,0x00,0x00,0x9C,0x01,0x00,0x00,0xD0,0x02,0x00,0x00,0x68,0x03,0x00,0x00,
+0x08,0x06,0x00,0x00,0x52,0x44,0x45,0x46,0x60,0x01,0x00,0x00,0x01,0x00,0x00,0x00,
+0x64,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x3C,0x00,0x00,0x00,0x00,0x05,0xFE,0xFF,
+0x00,0x01,0x00,0x00,0x38,0x01,0x00,0x00,0x52,0x44,0x31,0x31,0x3C,0x00,0x00,0x00,
+0x18,0x00,0x00,0x00,0x20,0x00,0x00,0x00,0x28,0x00,0x00,0x00,0x24,0x00,0x00,0x00,
+0x0C,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x5C,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x01,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x43,0x61,0x6D,0x65,0x72,0x61,0x00,0xAB,
+0x5C,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x7C,0x00,0x00,0x00,0x20,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xF4,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x08,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x04,0x01,0x00,0x00,0x00,0x00,0x00,0x00,
+0xFF,0xFF,0xFF,0xFF,0x00,0x00,0x00,0x00,0xFF,0xFF,0xFF,0xFF,0x00,0x00,0x00,0x00,
+0x28,0x01,0x00,0x00,0x08,0x00,0x00,0x00,0x08,0x00,0x00,0x00,0x02,0x00,0x00,0x00,
+0x04,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0xFF,0xFF,0xFF,0xFF,0x00,0x00,0x00,0x00,
+0xFF,0xFF,0xFF,0xFF,0x00,0x00,0x00,0x00,0x30,0x01,0x00,0x00,0x10,0x00,0x00,0x00,
+0x08,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x04,0x01,0x00,0x00,0x00,0x00,0x00,0x00,
+0xFF,0xFF,0xFF,0xFF,0x00,0x00,0x00,0x00,0xFF,0xFF,0xFF,0xFF,0x00,0x00,0x00,0x00,
+0x63,0x61,0x6D,0x65,0x72,0x61,0x30,0x00,0x66,0x6C,0x6F,0x61,0x74,0x32,0x00,0xAB,
+0x01,0x00,0x03,0x00,0x01,0x00,0x02,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0xFC,0x00,0x00,0x00,0x63,0x61,0x6D,0x65,0x72,0x61,0x31,0x00,0x63,0x61,0x6D,0x65,
+0x72,0x61,0x32,0x00,0x4D,0x69,0x63,0x72,0x6F,0x73,0x6F,0x66,0x74,0x20,0x28,0x52,
+0x29,0x20,0x48,0x4C,0x53,0x4C,0x20,0x53,0x68,0x61,0x64,0x65,0x72,0x20,0x43,0x6F,
+0x6D,0x70,0x69,0x6C,0x65,0x72,0x20,0x31,0x30,0x2E,0x31,0x00,0x49,0x53,0x47,0x4E,
+0x2C,0x01,0x00,0x00,0x0A,0x00,0x00,0x00,0x08,0x00,0x00,0x00,0xF8,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x03,0x03,0x00,0x00,0x01,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x03,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x03,0x03,0x00,0x00,0x0A,0x01,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x02,0x00,0x00,0x00,
+0x03,0x03,0x00,0x00,0x0A,0x01,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x03,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x03,0x03,0x00,0x00,0x0A,0x01,0x00,0x00,
+0x02,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x04,0x00,0x00,0x00,
+0x03,0x03,0x00,0x00,0x14,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x03,0x00,0x00,0x00,0x05,0x00,0x00,0x00,0x0F,0x0F,0x00,0x00,0x01,0x01,0x00,0x00,
+0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x06,0x00,0x00,0x00,
+0x03,0x03,0x00,0x00,0x01,0x01,0x00,0x00,0x02,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x03,0x00,0x00,0x00,0x07,0x00,0x00,0x00,0x03,0x03,0x00,0x00,0x1A,0x01,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x08,0x00,0x00,0x00,
+0x01,0x00,0x00,0x00,0x20,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x01,0x00,0x00,0x00,0x09,0x00,0x00,0x00,0x01,0x01,0x00,0x00,0x50,0x4F,0x53,0x49,
+0x54,0x49,0x4F,0x4E,0x00,0x54,0x45,0x58,0x43,0x4F,0x4F,0x52,0x44,0x00,0x54,0x52,
+0x41,0x4E,0x53,0x46,0x4F,0x52,0x4D,0x00,0x43,0x4F,0x4C,0x4F,0x52,0x00,0x4C,0x41,
+0x59,0x45,0x52,0x00,0x54,0x45,0x58,0x54,0x55,0x52,0x45,0x5F,0x49,0x44,0x00,0xAB,
+0x4F,0x53,0x47,0x4E,0x90,0x00,0x00,0x00,0x04,0x00,0x00,0x00,0x08,0x00,0x00,0x00,
+0x68,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x03,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x0F,0x00,0x00,0x00,0x74,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x0F,0x00,0x00,0x00,
+0x7A,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x03,0x00,0x00,0x00,
+0x02,0x00,0x00,0x00,0x03,0x0C,0x00,0x00,0x83,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x01,0x0E,0x00,0x00,
+0x53,0x56,0x5F,0x50,0x4F,0x53,0x49,0x54,0x49,0x4F,0x4E,0x00,0x43,0x4F,0x4C,0x4F,
+0x52,0x00,0x54,0x45,0x58,0x43,0x4F,0x4F,0x52,0x44,0x00,0x54,0x45,0x58,0x54,0x55,
+0x52,0x45,0x5F,0x49,0x44,0x00,0xAB,0xAB,0x53,0x48,0x45,0x58,0x98,0x02,0x00,0x00,
+0x50,0x00,0x01,0x00,0xA6,0x00,0x00,0x00,0x6A,0x08,0x00,0x01,0x59,0x00,0x00,0x04,
+0x46,0x8E,0x20,0x00,0x00,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x5F,0x00,0x00,0x03,
+0x32,0x10,0x10,0x00,0x00,0x00,0x00,0x00,0x5F,0x00,0x00,0x03,0x32,0x10,0x10,0x00,
+0x01,0x00,0x00,0x00,0x5F,0x00,0x00,0x03,0x32,0x10,0x10,0x00,0x02,0x00,0x00,0x00,
+0x5F,0x00,0x00,0x03,0x32,0x10,0x10,0x00,0x03,0x00,0x00,0x00,0x5F,0x00,0x00,0x03,
+0x32,0x10,0x10,0x00,0x04,0x00,0x00,0x00,0x5F,0x00,0x00,0x03,0xF2,0x10,0x10,0x00,
+0x05,0x00,0x00,0x00,0x5F,0x00,0x00,0x03,0x32,0x10,0x10,0x00,0x06,0x00,0x00,0x00,
+0x5F,0x00,0x00,0x03,0x32,0x10,0x10,0x00,0x07,0x00,0x00,0x00,0x5F,0x00,0x00,0x03,
+0x12,0x10,0x10,0x00,0x09,0x00,0x00,0x00,0x67,0x00,0x00,0x04,0xF2,0x20,0x10,0x00,
+0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x65,0x00,0x00,0x03,0xF2,0x20,0x10,0x00,
+0x01,0x00,0x00,0x00,0x65,0x00,0x00,0x03,0x32,0x20,0x10,0x00,0x02,0x00,0x00,0x00,
+0x65,0x00,0x00,0x03,0x12,0x20,0x10,0x00,0x03,0x00,0x00,0x00,0x68,0x00,0x00,0x02,
+0x02,0x00,0x00,0x00,0x36,0x00,0x00,0x05,0x32,0x00,0x10,0x00,0x00,0x00,0x00,0x00,
+0x46,0x10,0x10,0x00,0x00,0x00,0x00,0x00,0x36,0x00,0x00,0x05,0x42,0x00,0x10,0x00,
+0x00,0x00,0x00,0x00,0x01,0x40,0x00,0x00,0x00,0x00,0x80,0x3F,0x36,0x00,0x00,0x05,
+0x32,0x00,0x10,0x00,0x01,0x00,0x00,0x00,0x46,0x10,0x10,0x00,0x04,0x00,0x00,0x00,
+0x36,0x00,0x00,0x05,0x42,0x00,0x10,0x00,0x01,0x00,0x00,0x00,0x01,0x40,0x00,0x00,
+0x00,0x00,0x80,0x3F,0x10,0x00,0x00,0x07,0x42,0x00,0x10,0x00,0x00,0x00,0x00,0x00,
+0x46,0x02,0x10,0x00,0x00,0x00,0x00,0x00,0x46,0x02,0x10,0x00,0x01,0x00,0x00,0x00,
+0x36,0x00,0x00,0x06,0x32,0x00,0x10,0x00,0x01,0x00,0x00,0x00,0x46,0x80,0x20,0x00,
+0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x36,0x00,0x00,0x05,0x42,0x00,0x10,0x00,
+0x01,0x00,0x00,0x00,0x01,0x40,0x00,0x00,0x00,0x00,0x80,0x3F,0x0F,0x00,0x00,0x07,
+0x12,0x00,0x10,0x00,0x00,0x00,0x00,0x00,0x46,0x10,0x10,0x00,0x00,0x00,0x00,0x00,
+0x46,0x10,0x10,0x00,0x02,0x00,0x00,0x00,0x0F,0x00,0x00,0x07,0x22,0x00,0x10,0x00,
+0x00,0x00,0x00,0x00,0x46,0x10,0x10,0x00,0x00,0x00,0x00,0x00,0x46,0x10,0x10,0x00,
+0x03,0x00,0x00,0x00,0x10,0x00,0x00,0x07,0x42,0x00,0x10,0x00,0x00,0x00,0x00,0x00,
+0x46,0x02,0x10,0x00,0x00,0x00,0x00,0x00,0x46,0x02,0x10,0x00,0x01,0x00,0x00,0x00,
+0x32,0x00,0x00,0x09,0x42,0x20,0x10,0x00,0x00,0x00,0x00,0x00,0x2A,0x00,0x10,0x00,
+0x00,0x00,0x00,0x00,0x01,0x40,0x00,0x00,0x6F,0x12,0x03,0x3A,0x01,0x40,0x00,0x00,
+0x00,0x00,0x00,0x3F,0x36,0x00,0x00,0x05,0x82,0x20,0x10,0x00,0x00,0x00,0x00,0x00,
+0x01,0x40,0x00,0x00,0x00,0x00,0x80,0x3F,0x0F,0x00,0x00,0x08,0x12,0x20,0x10,0x00,
+0x00,0x00,0x00,0x00,0x46,0x00,0x10,0x00,0x00,0x00,0x00,0x00,0x46,0x80,0x20,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x0F,0x00,0x00,0x08,0x22,0x20,0x10,0x00,
+0x00,0x00,0x00,0x00,0x46,0x00,0x10,0x00,0x00,0x00,0x00,0x00,0xE6,0x8A,0x20,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x36,0x00,0x00,0x05,0xF2,0x20,0x10,0x00,
+0x01,0x00,0x00,0x00,0x46,0x1E,0x10,0x00,0x05,0x00,0x00,0x00,0x00,0x00,0x00,0x08,
+0x32,0x00,0x10,0x00,0x00,0x00,0x00,0x00,0x46,0x10,0x10,0x80,0x41,0x00,0x00,0x00,
+0x06,0x00,0x00,0x00,0x46,0x10,0x10,0x00,0x07,0x00,0x00,0x00,0x32,0x00,0x00,0x09,
+0x32,0x20,0x10,0x00,0x02,0x00,0x00,0x00,0x46,0x10,0x10,0x00,0x01,0x00,0x00,0x00,
+0x46,0x00,0x10,0x00,0x00,0x00,0x00,0x00,0x46,0x10,0x10,0x00,0x06,0x00,0x00,0x00,
+0x36,0x00,0x00,0x05,0x12,0x20,0x10,0x00,0x03,0x00,0x00,0x00,0x0A,0x10,0x10,0x00,
+0x09,0x00,0x00,0x00,0x3E,0x00,0x00,0x01,0x53,0x54,0x41,0x54,0x94,0x00,0x00,0x00,
+0x13,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x0D,0x00,0x00,0x00,
+0x09,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x09,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+0x00,0x00,0x00,0x00,
+};
+
+static const baked_blob baked_shaders_entries[] = {
+    { "sprite.vs.hlsl", baked_shaders_2, 1700 },
+    { "sprite.ps.hlsl", baked_shaders_1, 832 },
+};
+
+static const int32_t baked_shaders_seeds[] = {
+    -1,
+    -2,
+};
+
+extern const baked_table baked_shaders = {
+    baked_shaders_entries, baked_shaders_seeds, 2
 };
@@ -9,6 +9,8 @@
 -(void)startCommands;
 -(void)useNormalShader;
 -(void)usePixelArtShader;
+// The pipeline drawing instances uploaded in `format`
+-(id<MTLRenderPipelineState>)pipelineForFormat:(instance_format)format pixelArt:(bool)pixelArt;
 -(void)setTexture:(CNTextureArray *)array;
 -(void)drawWithInstances:(id<MTLBuffer>)instances;
 -(void)commitCommands;
@@ -20,6 +20,8 @@ static sprite_vertex kQuadVertices[] =
     id<MTLLibrary> _shaders;
     id<MTLRenderPipelineState> _normalPipeline;
     id<MTLRenderPipelineState> _pixelArtPipeline;
+    id<MTLRenderPipelineState> _packedPipeline;
+    id<MTLRenderPipelineState> _packedPixelArtPipeline;
     id<MTLBuffer> _quadVertexBuffer;
     
     id<MTLCommandBuffer> _currentCmdBuffer;
@@ -39,6 +41,13 @@ static sprite_vertex kQuadVertices[] =
     
 }
 
+-(id<MTLRenderPipelineState>)pipelineForFormat:(instance_format)format pixelArt:(bool)pixelArt
+{
+    if (format == INSTANCE_PACKED)
+        return pixelArt ? _packedPixelArtPipeline : _packedPipeline;
+    return pixelArt ? _pixelArtPipeline : _normalPipeline;
+}
+
 -(void)setTexture:(CNTextureArray *)array
 {
     drop(array);
@@ -98,6 +107,20 @@ static sprite_vertex kQuadVertices[] =
     error = [[NSError alloc] init];
     _pixelArtPipeline = [_device newRenderPipelineStateWithDescriptor:pipeDesc
                                                                 error:&error];
+
+    // Same fragment stages, reading packed_sprite_instance records
+    pipeDesc.vertexFunction = [_shaders newFunctionWithName:@"SpritePackedVertex"];
+    pipeDesc.fragmentFunction = [_shaders newFunctionWithName:@"SpriteFragment"];
+
+    error = [[NSError alloc] init];
+    _packedPipeline = [_device newRenderPipelineStateWithDescriptor:pipeDesc
+                                                              error:&error];
+
+    pipeDesc.fragmentFunction = [_shaders newFunctionWithName:@"SpritePixelFragment"];
+
+    error = [[NSError alloc] init];
+    _packedPixelArtPipeline = [_device newRenderPipelineStateWithDescriptor:pipeDesc
+                                                                      error:&error];
     
     return true;
     
@@ -10,8 +10,36 @@
              camera:(camera *)cam
            viewport:(const viewport *)vp;
 
+@property (nonatomic) instance_format instanceFormat;
+@property (nonatomic, readonly) vec2 gridSize;
+@property (nonatomic) bool threaded;
+
+-(void)setPrefetchFrames:(uint32_t)frames
+          instanceBudget:(uint32_t)budget;
+-(void)flushMutations;
+
+-(bool)setGridSize:(vec2)size;
+-(bool)retuneGridWithSpritesPerCell:(uint32_t)count;
+
+-(bool)saveToPath:(const char *)path
+    textureArrays:(texture_array *const *)arrays
+            count:(uint32_t)count;
+-(bool)loadFromPath:(const char *)path
+      textureArrays:(texture_array *const *)arrays
+              count:(uint32_t)count;
+-(bool)streamToPath:(const char *)path
+     residentBudget:(uint64_t)budget;
+@property (nonatomic, readonly) uint64_t residentBytes;
+-(bool)getPoolStats:(scene_pool)pool
+              into:(pool_stats *)stats;
+
 -(sprite_handle)newSpriteWithParams:(const sprite_params *)params;
 -(void)destroySprite:(sprite_handle)sprite;
+-(bool)newSprites:(uint32_t)count
+       withParams:(const sprite_params *)params
+          handles:(sprite_handle *)out;
+-(void)destroySprites:(const sprite_handle *)sprites
+                count:(uint32_t)count;
 
 -(void)getSpriteUv:(sprite_handle)sprite
          topLeftUv:(vec2 *)topLeft
@@ -20,6 +48,8 @@
 -(texture *)getSpriteTexture:(sprite_handle)sprite;
 -(matrix2d)getSpriteTransform:(sprite_handle)sprite;
 -(color)getSpriteTint:(sprite_handle)sprite;
+-(bool)isSpriteHidden:(sprite_handle)sprite;
+-(uint32_t)getSpriteTags:(sprite_handle)sprite;
 
 -(void)updateSprite:(sprite_handle)sprite
           topLeftUV:(vec2)topLeft
@@ -32,5 +62,29 @@
           transform:(matrix2d)transform;
 -(void)updateSprite:(sprite_handle)sprite
                tint:(color)tint;
+-(void)updateSprite:(sprite_handle)sprite
+             hidden:(bool)hidden;
+-(void)updateSprite:(sprite_handle)sprite
+               tags:(uint32_t)tags;
+
+-(bool)isTagVisible:(uint32_t)tag;
+-(void)setTag:(uint32_t)tag
+      visible:(bool)visible;
+
+-(tilemap *)newTilemapWithParams:(const tilemap_params *)params;
+-(void)destroyTilemap:(tilemap *)map;
+
+-(particle_emitter *)newEmitterWithParams:(const emitter_params *)params;
+-(void)destroyEmitter:(particle_emitter *)emitter;
+-(void)updateParticles:(float)dt;
+
+-(prefab *)newPrefabWithChildren:(const sprite_params *)children
+                           count:(uint32_t)count;
+-(bool)destroyPrefab:(prefab *)prefab;
+-(prefab_instance *)instantiatePrefab:(prefab *)prefab
+                            transform:(matrix2d)transform;
+-(void)destroyPrefabInstance:(prefab_instance *)instance;
+-(void)updatePrefabInstance:(prefab_instance *)instance
+                  transform:(matrix2d)transform;
 
 @end
@@ -2,14 +2,19 @@
 #import "InstanceBuffer.h"
 #import "backends/common/scene_graph.h"
 
+using scene_graph_t = scene_graph<
+    sprite_object,
+    sprite_instance,
+    InstanceBuffer,
+    error_interface
+>;
+using tilemap_type = scene_graph_t::tilemap_type;
+using emitter_type = scene_graph_t::emitter_type;
+using prefab_type = scene_graph_t::prefab_type;
+
 @implementation CNScene
 {
-    scene_graph<
-        sprite_object,
-        sprite_instance,
-        InstanceBuffer,
-        error_interface
-    > _graph;
+    scene_graph_t _graph;
 }
 
 -(instancetype)initWithSize:(vec2)size
@@ -32,6 +37,74 @@
     return set_error_and_ret(false, "Unimplemented");
 }
 
+-(void)setPrefetchFrames:(uint32_t)frames
+          instanceBudget:(uint32_t)budget
+{
+    _graph.set_prefetch(frames, budget);
+}
+-(void)flushMutations
+{
+    _graph.flush_mutations();
+}
+
+-(bool)threaded
+{
+    return _graph.is_threaded();
+}
+-(void)setThreaded:(bool)threaded
+{
+    _graph.set_threaded(threaded);
+}
+
+-(vec2)gridSize
+{
+    return _graph.get_grid_size();
+}
+-(bool)setGridSize:(vec2)size
+{
+    return _graph.set_grid_size(size);
+}
+-(bool)retuneGridWithSpritesPerCell:(uint32_t)count
+{
+    return _graph.retune_grid(count);
+}
+
+-(instance_format)instanceFormat
+{
+    return _graph.instance_layout();
+}
+-(void)setInstanceFormat:(instance_format)format
+{
+    _graph.set_instance_layout(format);
+}
+
+-(bool)saveToPath:(const char *)path
+    textureArrays:(texture_array *const *)arrays
+            count:(uint32_t)count
+{
+    return _graph.save_snapshot(path, arrays, count);
+}
+-(bool)loadFromPath:(const char *)path
+      textureArrays:(texture_array *const *)arrays
+              count:(uint32_t)count
+{
+    return _graph.load_snapshot(path, arrays, count);
+}
+-(bool)streamToPath:(const char *)path
+     residentBudget:(uint64_t)budget
+{
+    return _graph.set_streaming(path, budget);
+}
+-(uint64_t)residentBytes
+{
+    return _graph.get_resident_bytes();
+}
+-(bool)getPoolStats:(scene_pool)pool
+              into:(pool_stats *)stats
+{
+    return _graph.get_pool_stats(pool, stats);
+}
+
 -(sprite_handle)newSpriteWithParams:(const sprite_params *)params
 {
     return _graph.create_object(params);
@@ -40,44 +113,76 @@
 {
     _graph.destroy_object(sprite);
 }
+-(bool)newSprites:(uint32_t)count
+       withParams:(const sprite_params *)params
+          handles:(sprite_handle *)out
+{
+    return _graph.create_objects(params, count, out);
+}
+-(void)destroySprites:(const sprite_handle *)sprites
+                count:(uint32_t)count
+{
+    _graph.destroy_objects(sprites, count);
+}
+
+-(sprite_object *)resolveSprite:(sprite_handle)sprite
+{
+    if (sprite_object *obj = _graph.resolve(sprite))
+        return obj;
+    return set_error_and_ret("Stale or invalid sprite handle");
+}
 
 -(void)getSpriteUv:(sprite_handle)sprite
          topLeftUv:(vec2 *)topLeft
      bottomRightUv:(vec2 *)bottomRight
 {
-    *topLeft = sprite->uv0;
-    *bottomRight = sprite->uv1;
+    if (sprite_object *obj = [self resolveSprite:sprite])
+    {
+        *topLeft = obj->hot.uv0;
+        *bottomRight = obj->hot.uv1;
+    }
 }
 -(float)getSpriteLayer:(sprite_handle)sprite
 {
-    return sprite->layer;
+    sprite_object *obj = [self resolveSprite:sprite];
+    return obj ? obj->hot.layer : 0;
 }
 -(texture *)getSpriteTexture:(sprite_handle)sprite
 {
-    return sprite->tex;
+    sprite_object *obj = [self resolveSprite:sprite];
+    return obj ? obj->tex : nullptr;
 }
 -(matrix2d)getSpriteTransform:(sprite_handle)sprite
 {
-    return sprite->transform;
+    sprite_object *obj = [self resolveSprite:sprite];
+    return obj ? obj->hot.transform : matrix2d{};
 }
 -(color)getSpriteTint:(sprite_handle)sprite
 {
-    return sprite->tint;
+    sprite_object *obj = [self resolveSprite:sprite];
+    return obj ? obj->hot.tint : color{};
+}
+-(bool)isSpriteHidden:(sprite_handle)sprite
+{
+    sprite_object *obj = [self resolveSprite:sprite];
+    return obj && obj->hidden;
+}
+-(uint32_t)getSpriteTags:(sprite_handle)sprite
+{
+    sprite_object *obj = [self resolveSprite:sprite];
+    return obj ? obj->tags : 0;
 }
 
 -(void)updateSprite:(sprite_handle)sprite
           topLeftUV:(vec2)topLeft
       bottomRightUV:(vec2)bottomRight
 {
-    sprite->uv0 = topLeft;
-    sprite->uv1 = bottomRight;
-    _graph.updated_field(sprite);
+    _graph.set_uv(sprite, topLeft, bottomRight);
 }
 -(void)updateSprite:(sprite_handle)sprite
               layer:(float)layer
 {
-    sprite->layer = layer;
-    _graph.updated_layer(sprite);
+    _graph.set_layer(sprite, layer);
 }
 -(void)updateSprite:(sprite_handle)sprite
             texture:(texture *)texture
@@ -92,8 +197,73 @@
 -(void)updateSprite:(sprite_handle)sprite
                tint:(color)tint
 {
-    sprite->tint = tint;
-    _graph.updated_field(sprite);
+    _graph.set_tint(sprite, tint);
+}
+-(void)updateSprite:(sprite_handle)sprite
+             hidden:(bool)hidden
+{
+    _graph.set_hidden(sprite, hidden);
+}
+-(void)updateSprite:(sprite_handle)sprite
+               tags:(uint32_t)tags
+{
+    _graph.set_tags(sprite, tags);
+}
+
+-(bool)isTagVisible:(uint32_t)tag
+{
+    return _graph.is_tag_visible(tag);
+}
+-(void)setTag:(uint32_t)tag
+      visible:(bool)visible
+{
+    _graph.set_tag_visible(tag, visible);
+}
+
+-(tilemap *)newTilemapWithParams:(const tilemap_params *)params
+{
+    return (tilemap *)_graph.create_tilemap(params);
+}
+-(void)destroyTilemap:(tilemap *)map
+{
+    _graph.destroy_tilemap((tilemap_type *)map);
+}
+
+-(particle_emitter *)newEmitterWithParams:(const emitter_params *)params
+{
+    return (particle_emitter *)_graph.create_emitter(params);
+}
+-(void)destroyEmitter:(particle_emitter *)emitter
+{
+    _graph.destroy_emitter((emitter_type *)emitter);
+}
+
+-(prefab *)newPrefabWithChildren:(const sprite_params *)children
+                           count:(uint32_t)count
+{
+    return (prefab *)_graph.create_prefab(children, count);
+}
+-(bool)destroyPrefab:(prefab *)prefab
+{
+    return _graph.destroy_prefab((prefab_type *)prefab);
+}
+-(prefab_instance *)instantiatePrefab:(prefab *)prefab
+                            transform:(matrix2d)transform
+{
+    return (prefab_instance *)(uintptr_t)_graph.instantiate_prefab((prefab_type *)prefab, transform);
+}
+-(void)destroyPrefabInstance:(prefab_instance *)instance
+{
+    _graph.destroy_prefab_instance((uint32_t)(uintptr_t)instance);
+}
+-(void)updatePrefabInstance:(prefab_instance *)instance
+                  transform:(matrix2d)transform
+{
+    _graph.move_prefab_instance((uint32_t)(uintptr_t)instance, transform);
+}
+-(void)updateParticles:(float)dt
+{
+    _graph.update_particles(dt);
 }
 
 @end
@@ -119,6 +289,97 @@ bool rd_draw_scene(device *dev, render_target *rt, scene *pscene, camera *cam, c
                       viewport:vp];
 }
 
+void rd_set_scene_prefetch(scene *pscene, uint32_t lookahead_frames, uint32_t instance_budget)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    [scene setPrefetchFrames:lookahead_frames
+              instanceBudget:instance_budget];
+}
+
+bool rd_is_scene_threaded(scene *pscene)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    return scene.threaded;
+}
+
+void rd_set_scene_threaded(scene *pscene, bool threaded)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    scene.threaded = threaded;
+}
+
+void rd_flush_scene_mutations(scene *pscene)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    [scene flushMutations];
+}
+
+void rd_get_scene_grid_size(scene *pscene, vec2 *size)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    *size = scene.gridSize;
+}
+
+bool rd_set_scene_grid_size(scene *pscene, const vec2 *size)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    return [scene setGridSize:*size];
+}
+
+bool rd_retune_scene_grid(scene *pscene, uint32_t sprites_per_cell)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    return [scene retuneGridWithSpritesPerCell:sprites_per_cell];
+}
+
+instance_format rd_get_scene_instance_format(scene *pscene)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    return scene.instanceFormat;
+}
+
+void rd_set_scene_instance_format(scene *pscene, instance_format format)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    scene.instanceFormat = format;
+}
+
+bool rd_save_scene(scene *pscene, const char *path, texture_array *const *arrays, uint32_t array_count)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    return [scene saveToPath:path
+               textureArrays:arrays
+                       count:array_count];
+}
+
+bool rd_load_scene(scene *pscene, const char *path, texture_array *const *arrays, uint32_t array_count)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    return [scene loadFromPath:path
+                 textureArrays:arrays
+                         count:array_count];
+}
+
+bool rd_set_scene_streaming(scene *pscene, const char *page_file, uint64_t resident_budget)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    return [scene streamToPath:page_file
+                residentBudget:resident_budget];
+}
+
+uint64_t rd_get_scene_resident_bytes(scene *pscene)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    return scene.residentBytes;
+}
+
+bool rd_get_scene_pool_stats(scene *pscene, scene_pool pool, pool_stats *stats)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    return [scene getPoolStats:pool
+                          into:stats];
+}
+
 sprite_handle rd_create_sprite(scene *pscene, const sprite_params *params)
 {
     auto scene = ref_objc<CNScene>(pscene);
@@ -131,6 +392,21 @@ void rd_destroy_sprite(scene *pscene, sprite_handle sprite)
     [scene destroySprite:sprite];
 }
 
+bool rd_create_sprites(scene *pscene, const sprite_params *params, uint32_t count, sprite_handle *out)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    return [scene newSprites:count
+                  withParams:params
+                     handles:out];
+}
+
+void rd_destroy_sprites(scene *pscene, const sprite_handle *sprites, uint32_t count)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    [scene destroySprites:sprites
+                    count:count];
+}
+
 void rd_get_sprite_uv(scene *pscene, sprite_handle sprite, vec2 *topleft, vec2 *bottomright)
 {
     auto scene = ref_objc<CNScene>(pscene);
@@ -199,3 +475,134 @@ void rd_set_sprite_tint(scene *pscene, sprite_handle sprite, const color *tint)
                    tint:*tint];
 }
 
+bool rd_is_sprite_hidden(scene *pscene, sprite_handle sprite)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    return [scene isSpriteHidden:sprite];
+}
+
+void rd_set_sprite_hidden(scene *pscene, sprite_handle sprite, bool hidden)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    [scene updateSprite:sprite
+                 hidden:hidden];
+}
+
+uint32_t rd_get_sprite_tags(scene *pscene, sprite_handle sprite)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    return [scene getSpriteTags:sprite];
+}
+
+void rd_set_sprite_tags(scene *pscene, sprite_handle sprite, uint32_t tags)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    [scene updateSprite:sprite
+                   tags:tags];
+}
+
+bool rd_is_scene_tag_visible(scene *pscene, uint32_t tag)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    return [scene isTagVisible:tag];
+}
+
+void rd_set_scene_tag_visible(scene *pscene, uint32_t tag, bool visible)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    [scene setTag:tag
+          visible:visible];
+}
+
+tilemap *rd_create_tilemap(scene *pscene, const tilemap_params *params)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    return [scene newTilemapWithParams:params];
+}
+
+void rd_destroy_tilemap(scene *pscene, tilemap *map)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    [scene destroyTilemap:map];
+}
+
+uint16_t rd_get_tile(scene *, tilemap *map, uint32_t x, uint32_t y)
+{
+    return ((tilemap_type *)map)->get(x, y);
+}
+
+void rd_set_tile(scene *, tilemap *map, uint32_t x, uint32_t y, uint16_t tile)
+{
+    ((tilemap_type *)map)->set(x, y, tile);
+}
+
+void rd_set_tile_region(scene *, tilemap *map, uint32_t x, uint32_t y, uint32_t w, uint32_t h, const uint16_t *tiles)
+{
+    ((tilemap_type *)map)->set_region(x, y, w, h, tiles);
+}
+
+particle_emitter *rd_create_emitter(scene *pscene, const emitter_params *params)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    return [scene newEmitterWithParams:params];
+}
+
+void rd_destroy_emitter(scene *pscene, particle_emitter *emitter)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    [scene destroyEmitter:emitter];
+}
+
+void rd_set_emitter_position(scene *, particle_emitter *emitter, const vec2 *position)
+{
+    ((emitter_type *)emitter)->set_position(*position);
+}
+
+uint32_t rd_get_particle_count(scene *, particle_emitter *emitter)
+{
+    return ((emitter_type *)emitter)->count();
+}
+
+void rd_emit_particles(scene *, particle_emitter *emitter, uint32_t count)
+{
+    ((emitter_type *)emitter)->emit(count);
+}
+
+void rd_update_particles(scene *pscene, float dt)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    [scene updateParticles:dt];
+}
+
+prefab *rd_create_prefab(scene *pscene, const sprite_params *children, uint32_t count)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    return [scene newPrefabWithChildren:children
+                                  count:count];
+}
+
+bool rd_destroy_prefab(scene *pscene, prefab *prefab)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    return [scene destroyPrefab:prefab];
+}
+
+prefab_instance *rd_instantiate_prefab(scene *pscene, prefab *prefab, const matrix2d *transform)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    return [scene instantiatePrefab:prefab
+                          transform:*transform];
+}
+
+void rd_destroy_prefab_instance(scene *pscene, prefab_instance *instance)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    [scene destroyPrefabInstance:instance];
+}
+
+void rd_set_prefab_instance_transform(scene *pscene, prefab_instance *instance, const matrix2d *transform)
+{
+    auto scene = ref_objc<CNScene>(pscene);
+    [scene updatePrefabInstance:instance
+                      transform:*transform];
+}
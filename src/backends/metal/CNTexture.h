@@ -11,6 +11,11 @@
 @property (readonly) bool streaming;
 @property (readonly) id<MTLTexture> textureArray;
 @property (readonly) NSArray *textures;
+@property (readonly, unsafe_unretained) CNTextureArray *lod;
+@property (readonly) float lodMaxPixels;
+
+-(bool)setLod:(CNTextureArray *)lower
+    maxPixels:(float)maxPixelsPerUnit;
 
 @end
 
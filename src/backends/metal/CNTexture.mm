@@ -68,6 +68,27 @@
                    bytesPerImage:_width * _height * 4];
 }
 
+-(bool)setLod:(CNTextureArray *)lower
+    maxPixels:(float)maxPixelsPerUnit
+{
+    if (lower)
+    {
+        if (lower.spriteCount != _spriteCount)
+            return set_error_and_ret(false, "LOD texture array must have the same sprite count");
+        if (lower.width > _width || lower.height > _height)
+            return set_error_and_ret(false, "LOD texture array must not be larger than its parent");
+        for (CNTextureArray *it = lower; it; it = it.lod)
+        {
+            if (it == self)
+                return set_error_and_ret(false, "LOD chain would loop");
+        }
+    }
+
+    _lod = lower;
+    _lodMaxPixels = maxPixelsPerUnit;
+    return true;
+}
+
 @end
 
 @implementation CNTexture
@@ -136,6 +157,21 @@ void rd_set_texture_array_pixel_art(texture_array *set, bool pa)
     texture.isPixelArt = pa;
 }
 
+bool rd_set_texture_array_lod(texture_array *set, texture_array *lower, float max_pixels_per_unit)
+{
+    auto texture = ref_objc<CNTextureArray>(set);
+    return [texture setLod:ref_objc<CNTextureArray>(lower)
+                 maxPixels:max_pixels_per_unit];
+}
+
+texture_array *rd_get_texture_array_lod(const texture_array *set, float *max_pixels_per_unit)
+{
+    auto texture = ref_objc<CNTextureArray>(set);
+    if (max_pixels_per_unit)
+        *max_pixels_per_unit = texture.lodMaxPixels;
+    return ref_objc<texture_array>(texture.lod);
+}
+
 texture *rd_get_texture(texture_array *set, uint32_t index)
 {
     auto texture = ref_objc<CNTextureArray>(set);
@@ -151,6 +187,11 @@ texture_array *rd_get_texture_array(texture *tex)
     return ref_objc<texture_array>(texture.array);
 }
 
+uint32_t rd_get_texture_index(texture *tex)
+{
+    return ref_objc<CNTexture>(tex).index;
+}
+
 bool rd_update_texture(device *, texture *tex,
                        const uint8_t *data, size_t len)
 {
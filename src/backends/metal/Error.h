@@ -38,6 +38,12 @@ inline std::nullptr_t append_error_and_ret(const char *msg)
 
 struct error_interface
 {
+    template <typename T>
+    static T set_ret(T ret, const char *msg)
+    {
+        return set_error_and_ret(ret, msg);
+    }
+
     template <typename T>
     static T append_ret(T ret, const char *msg)
     {
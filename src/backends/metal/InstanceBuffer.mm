@@ -6,11 +6,14 @@ ib_state::ib_state()
     rd_ib_deactivate(*this);
 }
 
-static bool should_resize(uint32_t count, ib_state &state)
+static bool should_resize(uint32_t count, uint32_t isize, ib_state &state)
 {
     if (!state.buffer)
         return true;
 
+    if (state.stride != isize)
+        return true;
+
     if (state.cap < count)
         return true;
 
@@ -30,7 +33,7 @@ bool rd_ib_start_upload(device *pdev, uint32_t count, uint32_t isize, ib_state &
 
     auto dev = ref_objc<CNDevice>(pdev);
 
-    if (should_resize(count, state))
+    if (should_resize(count, isize, state))
     {
         rd_ib_deactivate(state);
         uint32_t new_cap = uint32_t(count * 1.5);
@@ -43,11 +46,13 @@ bool rd_ib_start_upload(device *pdev, uint32_t count, uint32_t isize, ib_state &
             return set_error_and_ret(false, "Failed to create Metal buffer");
 
         state.cap = new_cap;
+        state.stride = isize;
     }
     
     memmove(state.previous_counts + 1, state.previous_counts, 7 * sizeof(uint32_t));
     state.previous_counts[0] = count;
 
+    state.idx = 0;
     state.written_bytes = 0;
     state.mapped_data = (uint8_t *)[state.buffer contents];
     if (state.mapped_data == nullptr)
@@ -68,6 +73,16 @@ void rd_ib_push(const void *data, uint32_t size, uint32_t count, ib_state &state
     state.written_bytes += size * count;
 }
 
+void *rd_ib_reserve(uint32_t size, uint32_t count, ib_state &state)
+{
+    assert(state.idx + count <= state.cap);
+    auto dst = state.mapped_data + size * state.idx;
+
+    state.idx += count;
+    state.written_bytes += size * count;
+    return dst;
+}
+
 bool rd_ib_finish(device *, ib_state &state)
 {
     #ifdef MACOS
@@ -80,5 +95,6 @@ void rd_ib_deactivate(ib_state &state)
 {
     state.buffer = nil;
     state.cap = 0;
+    state.stride = 0;
     memset(state.previous_counts, 0xFF, sizeof(state.previous_counts));
 }
@@ -27,6 +27,17 @@ struct SpriteInstance
     uint texture_id;
 };
 
+// Matches packed_sprite_instance in backends/common/packed_instance.h
+struct PackedSpriteInstance
+{
+    packed_half4 linear;
+    packed_float2 translation;
+    uchar4 tint;
+    packed_half4 uv;
+    half layer;
+    ushort texture_id;
+};
+
 struct VertexOut
 {
     float4 position [[position]];
@@ -68,6 +79,36 @@ vertex VertexOut SpriteVertex(constant SpriteVertex *vertices [[buffer(0)]],
     return vert;
 }
 
+vertex VertexOut SpritePackedVertex(constant SpriteVertex *vertices [[buffer(0)]],
+                                    constant PackedSpriteInstance *instances [[buffer(1)]],
+                                    constant Uniforms *uniforms [[buffer(2)]],
+                                    uint vert_id [[vertex_id]],
+                                    uint inst_id [[instance_id]])
+{
+    constant PackedSpriteInstance &inst = instances[inst_id];
+    float4 linear = float4(half4(inst.linear));
+
+    float3 pos = float3(vertices[vert_id].pos, 1);
+    float2 tcoord = vertices[vert_id].tex;
+    float3x3 camera = Affine2D(uniforms->camera);
+    float3x3 transform = float3x3(
+        float3(linear.xy, 0),
+        float3(linear.zw, 0),
+        float3(float2(inst.translation), 1)
+    );
+    pos = camera * (transform * pos);
+
+    float4 uv = float4(half4(inst.uv));
+    tcoord = uv.xy * tcoord + uv.zw * (1 - tcoord);
+
+    VertexOut vert;
+    vert.position = float4(pos.xy, pos.z / 2000 + 0.5, 1);
+    vert.tint = half4(float4(inst.tint) / 255.0);
+    vert.texcoord = tcoord;
+    vert.tex_id = inst.texture_id;
+    return vert;
+}
+
 fragment half4 SpriteFragment(VertexOut inFrag [[stage_in]],
                               texture2d_array<half> tex2D [[texture(0)]])
 {
@@ -16,7 +16,10 @@ struct sprite_instance
     uint32_t texture_id;
 };
 
-struct sprite_object
+// Sprites are split so batching only reads `hot`, which is exactly the
+// instance uploaded to the GPU and starts on its own cache line. The cold
+// half is bookkeeping the scene graph needs when sprites are placed.
+struct alignas(64) sprite_object
 {
     sprite_object(const pool_allocation &alloc, const sprite_params *params)
         : alloc(alloc)
@@ -28,34 +31,29 @@ struct sprite_object
         else
             type = sprite_class::standard;
 
-        transform = params->transform;
-        tint = params->tint;
-        uv0 = params->uv_topleft;
-        uv1 = params->uv_bottomright;
-        layer = params->layer;
+        hot.transform = params->transform;
+        hot.tint = params->tint;
+        hot.uv0 = params->uv_topleft;
+        hot.uv1 = params->uv_bottomright;
+        hot.layer = params->layer;
+        hot.texture_id = rd_get_texture_index(params->tex);
         tex = params->tex;
+        tags = params->tags;
+        hidden = false;
     }
 
-    matrix2d transform;
-    color tint;
-    vec2 uv0, uv1;
-    float layer;
-    texture *tex;
+    sprite_instance hot;
 
+    texture *tex;
     pool_allocation alloc;
+    uint32_t tags;
     sprite_class type;
-
-    inline explicit operator sprite_instance()
-    {
-        sprite_instance inst;
-        inst.transform = transform;
-        inst.tint = tint;
-        inst.uv0 = uv0;
-        inst.uv1 = uv1;
-        inst.layer = layer;
-        //inst.texture_id = tex->index;
-        return inst;
-    }
+    bool hidden;
 };
 
+// Size budgets: one cache line of hot data, at most one of cold data
+static_assert(sizeof(sprite_instance) == 64, "sprite_instance must fill exactly one cache line");
+static_assert(alignof(sprite_object) == 64, "sprites must start on a cache line");
+static_assert(sizeof(sprite_object) <= 128, "cold sprite data must fit in one cache line");
+
 
@@ -1,8 +1,12 @@
+package.path = "src/?.lua;"..package.path
+
 local io = require("io")
 local os = require("os")
+local baked_table = require("engine.utility.baked_table")
 local args = { ... }
 
 local baked_shaders
+local shader_blobs
 local function begin_shaders()
     baked_shaders = io.open("src/backends/"..args[1].."/baked_shaders.cpp", "w+")
     if args[1] ~= 'metal' then
@@ -10,13 +14,10 @@ local function begin_shaders()
         baked_shaders:write('\n')
     end
     baked_shaders:write[[
-#include <unordered_map>
-#include <string>
-using namespace std::string_literals;
+#include <backends/common/baked_shaders.h>
 
-std::unordered_map<std::string, std::string> baked_shaders =
-std::unordered_map<std::string, std::string> {
 ]]
+    shader_blobs = {}
 end
 
 local function output_shader(name, file)
@@ -24,17 +25,11 @@ local function output_shader(name, file)
     local data = datafile:read("*a")
     datafile:close()
 
-    baked_shaders:write('{"')
-    baked_shaders:write(name)
-    baked_shaders:write('"s,"')
-    for i = 1, #data do
-        baked_shaders:write(string.format("\\x%02X", string.byte(data, i)))
-    end
-    baked_shaders:write('"s},\n')
+    shader_blobs[#shader_blobs + 1] = { name = name, data = data }
 end
 
 local function end_shaders()
-    baked_shaders:write("};\n")
+    baked_table.write(baked_shaders, "baked_shaders", shader_blobs)
     baked_shaders:close()
 end
 
@@ -44,7 +39,7 @@ if args[1] == 'dx11' then
     local fxc = powershell..' '..fxcps1
     local shader_dir = "src/backends/shaders/dx11/"
 
-    local shaders = { "sprite.ps.hlsl", "sprite.vs.hlsl" }
+    local shaders = { "sprite.ps.hlsl", "sprite.vs.hlsl", "sprite_packed.vs.hlsl" }
 
     local success = true
     for i, shader in ipairs(shaders) do
@@ -0,0 +1,87 @@
+// Keeps a hashmap at a steady size while replacing its keys, and reports
+// how probe lengths and operation times hold up as it churns. With
+// backward shift deletion they should stay flat; with tombstones they
+// creep up until the next rehash.
+//
+//     hashmap-bench [entries] [rounds]
+
+#include "backends/common/hashmap.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+using clock_type = std::chrono::steady_clock;
+
+template <typename Hasher>
+static void churn(const char *name, size_t entries, uint32_t rounds)
+{
+    hashmap<uint64_t, uint64_t, Hasher> map;
+    std::vector<uint64_t> keys;
+    keys.reserve(entries);
+
+    std::mt19937_64 rng(12345);
+    while (keys.size() < entries)
+    {
+        uint64_t key = rng();
+        if (!map.insert(key, key))
+            keys.push_back(key);
+    }
+
+    hashmap_probe_stats start = map.probe_stats();
+    printf("%s: %zu entries\n", name, entries);
+    printf("  round %5u  mean probe %.3f  longest %zu\n", 0u, start.mean, start.longest);
+
+    // Each round swaps out a quarter of the keys, a random one at a time
+    size_t per_round = entries / 4;
+    for (uint32_t round = 1; round <= rounds; ++round)
+    {
+        auto t0 = clock_type::now();
+        for (size_t i = 0; i < per_round; ++i)
+        {
+            size_t victim = size_t(rng() % keys.size());
+            map.remove(keys[victim]);
+
+            uint64_t key = rng();
+            while (map.get(key))
+                key = rng();
+            map.insert(key, key);
+            keys[victim] = key;
+        }
+        auto t1 = clock_type::now();
+
+        uint64_t found = 0;
+        for (uint64_t key : keys)
+            found += map.get(key) ? 1 : 0;
+        auto t2 = clock_type::now();
+
+        if (found != keys.size() || map.size() != keys.size())
+        {
+            fprintf(stderr, "%s: lost entries in round %u\n", name, round);
+            exit(1);
+        }
+
+        hashmap_probe_stats stats = map.probe_stats();
+        double churn_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / double(per_round);
+        double get_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / double(keys.size());
+        printf("  round %5u  mean probe %.3f  longest %zu  remove+insert %.1f ns  get %.1f ns\n",
+            round, stats.mean, stats.longest, churn_ns, get_ns);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t entries = argc > 1 ? (size_t)strtoull(argv[1], nullptr, 10) : 1000000;
+    uint32_t rounds = argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 10) : 20;
+    if (entries < 4)
+    {
+        fprintf(stderr, "usage: %s [entries >= 4] [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    churn<HashPolicy::Fast>("Fast", entries, rounds);
+    churn<HashPolicy::DosResistant>("DosResistant", entries, rounds);
+    return 0;
+}
@@ -1,6 +1,15 @@
 local ffi = require("engine.graphics.renderer.typedefs")
 
 ffi.rd_header.cdef[[
+    // Per-instance vertex layout a scene uploads its batches in.
+    // INSTANCE_PACKED halves the bandwidth with half-float UVs,
+    // transform rotation/scale and layer, an 8-bit tint and a
+    // 16-bit texture index.
+    enum instance_format #ENUM {
+        INSTANCE_FULL = 0,
+        INSTANCE_PACKED = 1,
+    };
+
     struct sprite_params {
         bool is_translucent;
         bool is_static;
@@ -10,6 +19,8 @@ ffi.rd_header.cdef[[
         vec2 uv_bottomright;
         matrix2d transform;
         color tint;
+        // Bitmask of tags 0-31, see rd_set_scene_tag_visible
+        uint32_t tags;
     };
 
     scene *rd_create_scene(device *dev, float grid_width, float grid_height);
@@ -17,8 +28,74 @@ ffi.rd_header.cdef[[
 
     bool rd_draw_scene(device *dev, render_target *rt, scene *scene, camera *cam, const viewport *vp);
 
+    // Prepares cells along the camera's predicted path `lookahead_frames`
+    // ahead, uploading at most `instance_budget` instances per frame.
+    // A lookahead of 0 turns prediction off.
+    void rd_set_scene_prefetch(scene *scene, uint32_t lookahead_frames, uint32_t instance_budget);
+
+    // In threaded mode sprites can be created, destroyed and changed from
+    // any thread. Each thread queues its changes without contending with
+    // the others and the queues are applied when the scene is next drawn,
+    // saved or flushed. Getters see the state as of the last flush and must
+    // not run while the scene is drawn or flushed. Only switch modes while
+    // no other thread is using the scene.
+    bool rd_is_scene_threaded(scene *scene);
+    void rd_set_scene_threaded(scene *scene, bool threaded);
+    void rd_flush_scene_mutations(scene *scene);
+
+    void rd_get_scene_grid_size(scene *scene, vec2 *size);
+    bool rd_set_scene_grid_size(scene *scene, const vec2 *size);
+    // Picks a new cell size from the scene's sprite density so the median
+    // sprite shares its cell with about `sprites_per_cell` sprites.
+    bool rd_retune_scene_grid(scene *scene, uint32_t sprites_per_cell);
+
+    instance_format rd_get_scene_instance_format(scene *scene);
+    void rd_set_scene_instance_format(scene *scene, instance_format format);
+
+    bool rd_save_scene(scene *scene, const char *path, texture_array *const *arrays, uint32_t array_count);
+    bool rd_load_scene(scene *scene, const char *path, texture_array *const *arrays, uint32_t array_count);
+
+    // Pages baked (snapshot loaded) sprites of far away grid groups out to
+    // `page_file` while more than `resident_budget` bytes of them are loaded,
+    // and streams them back in on a background thread as the camera nears.
+    // Saving or regridding loads everything back first. A null path turns
+    // streaming off.
+    bool rd_set_scene_streaming(scene *scene, const char *page_file, uint64_t resident_budget);
+    uint64_t rd_get_scene_resident_bytes(scene *scene);
+
+    // The pools a scene keeps sprites and prefab instances in
+    enum scene_pool #ENUM {
+        SCENE_POOL_SPRITES = 0,
+        SCENE_POOL_PREFAB_INSTANCES = 1,
+    };
+
+    struct pool_stats {
+        uint32_t live;
+        uint32_t buckets;
+        uint64_t reserved_bytes;
+        uint64_t committed_bytes;
+        // Cells handed to the pool's free lists, waiting for an object
+        uint32_t free_cells;
+        // Between the last two draws of the scene
+        uint32_t frame_allocs;
+        uint32_t frame_frees;
+        // Since the scene was created
+        uint64_t total_allocs;
+        uint64_t total_frees;
+        // free_cells / (live + free_cells)
+        float fragmentation;
+    };
+
+    bool rd_get_scene_pool_stats(scene *scene, scene_pool pool, pool_stats *stats);
+
+    // Returns 0 on failure
     sprite_handle rd_create_sprite(scene *scene, const sprite_params *params);
     void rd_destroy_sprite(scene *scene, sprite_handle sprite);
+    // Creates `count` sprites from `params[0..count)`, writing their handles
+    // to `out`. Sprites created together sit next to each other in memory.
+    // Creates none and fails if the scene can't hold them all.
+    bool rd_create_sprites(scene *scene, const sprite_params *params, uint32_t count, sprite_handle *out);
+    void rd_destroy_sprites(scene *scene, const sprite_handle *sprites, uint32_t count);
 
     void rd_get_sprite_uv(scene *scene, sprite_handle sprite, vec2 *topleft, vec2 *bottomright);
     void rd_set_sprite_uv(scene *scene, sprite_handle sprite, const vec2 *topleft, const vec2 *bottomright);
@@ -34,6 +111,80 @@ ffi.rd_header.cdef[[
 
     void rd_get_sprite_tint(scene *scene, sprite_handle sprite, color *tint);
     void rd_set_sprite_tint(scene *scene, sprite_handle sprite, const color *tint);
+
+    // Hidden sprites stay in their cell but are left out of batches
+    bool rd_is_sprite_hidden(scene *scene, sprite_handle sprite);
+    void rd_set_sprite_hidden(scene *scene, sprite_handle sprite, bool hidden);
+
+    uint32_t rd_get_sprite_tags(scene *scene, sprite_handle sprite);
+    void rd_set_sprite_tags(scene *scene, sprite_handle sprite, uint32_t tags);
+
+    // Hides or shows every sprite carrying `tag` (0-31). This is O(1),
+    // batches are rebuilt lazily as their cells are next prepared.
+    bool rd_is_scene_tag_visible(scene *scene, uint32_t tag);
+    void rd_set_scene_tag_visible(scene *scene, uint32_t tag, bool visible);
+
+    // Tile 0 is empty, tile N draws slice N-1 of `tiles`.
+    // Tile (0, 0) has its bottom-left corner at `origin`.
+    struct tilemap_params {
+        texture_array *tiles;
+        uint32_t width;
+        uint32_t height;
+        vec2 origin;
+        vec2 tile_size;
+        float layer;
+        color tint;
+    };
+
+    tilemap *rd_create_tilemap(scene *scene, const tilemap_params *params);
+    void rd_destroy_tilemap(scene *scene, tilemap *map);
+
+    uint16_t rd_get_tile(scene *scene, tilemap *map, uint32_t x, uint32_t y);
+    void rd_set_tile(scene *scene, tilemap *map, uint32_t x, uint32_t y, uint16_t tile);
+    void rd_set_tile_region(scene *scene, tilemap *map, uint32_t x, uint32_t y, uint32_t w, uint32_t h, const uint16_t *tiles);
+
+    // Particles are drawn as `tex` quads centered on their position. Size
+    // and color are interpolated from start to end over each lifetime.
+    // `emit_rate` is particles per second spawned by rd_update_particles,
+    // 0 only emits on rd_emit_particles.
+    struct emitter_params {
+        texture *tex;
+        vec2 uv_topleft;
+        vec2 uv_bottomright;
+        vec2 position;
+        vec2 velocity_min;
+        vec2 velocity_max;
+        vec2 acceleration;
+        float lifetime_min;
+        float lifetime_max;
+        float size_start;
+        float size_end;
+        color color_start;
+        color color_end;
+        float layer;
+        float emit_rate;
+        uint32_t max_particles;
+    };
+
+    particle_emitter *rd_create_emitter(scene *scene, const emitter_params *params);
+    void rd_destroy_emitter(scene *scene, particle_emitter *emitter);
+
+    void rd_set_emitter_position(scene *scene, particle_emitter *emitter, const vec2 *position);
+    uint32_t rd_get_particle_count(scene *scene, particle_emitter *emitter);
+    void rd_emit_particles(scene *scene, particle_emitter *emitter, uint32_t count);
+    void rd_update_particles(scene *scene, float dt);
+
+    // A prefab stores its child sprites once, relative to its root. Each
+    // instance only keeps a transform and its children are expanded when
+    // its cell is prepared. Children can't be translucent and ignore tags.
+    // Prefabs are created and placed from the drawing thread only.
+    prefab *rd_create_prefab(scene *scene, const sprite_params *children, uint32_t count);
+    // Fails while the prefab still has instances
+    bool rd_destroy_prefab(scene *scene, prefab *prefab);
+
+    prefab_instance *rd_instantiate_prefab(scene *scene, prefab *prefab, const matrix2d *transform);
+    void rd_destroy_prefab_instance(scene *scene, prefab_instance *instance);
+    void rd_set_prefab_instance_transform(scene *scene, prefab_instance *instance, const matrix2d *transform);
 ]]
 
 return ffi
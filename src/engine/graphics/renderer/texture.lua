@@ -19,8 +19,17 @@ ffi.rd_header.cdef[[
     bool rd_is_texture_array_pixel_art(const texture_array *set);
     void rd_set_texture_array_pixel_art(texture_array *set, bool pa);
 
+    // Links a downscaled copy of `set` to draw from while the camera shows
+    // at most `max_pixels_per_unit` screen pixels per world unit. `lower`
+    // needs the same sprite count and layout and may have a chain of its own
+    // (with smaller thresholds). Streaming updates are not forwarded to it.
+    // Pass null to unlink. `lower` must outlive the link.
+    bool rd_set_texture_array_lod(texture_array *set, texture_array *lower, float max_pixels_per_unit);
+    texture_array *rd_get_texture_array_lod(const texture_array *set, float *max_pixels_per_unit);
+
     texture *rd_get_texture(texture_array *set, uint32_t index);
     texture_array *rd_get_texture_array(texture *texture);
+    uint32_t rd_get_texture_index(texture *texture);
     bool rd_update_texture(device *dev, texture *texture, const uint8_t *data, size_t len);
 ]]
 
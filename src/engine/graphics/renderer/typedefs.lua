@@ -42,8 +42,19 @@ ffi.rd_header.cdef[[
 
     // Scene
     typedef struct scene scene;
-    typedef struct sprite_object *sprite_handle;
+    // Slot index and generation; 0 is never a valid sprite, and handles of
+    // destroyed sprites are ignored by setters
+    typedef uint32_t sprite_handle;
     typedef struct sprite_params sprite_params;
+    typedef enum instance_format #ENUM instance_format;
+    typedef enum scene_pool #ENUM scene_pool;
+    typedef struct pool_stats pool_stats;
+    typedef struct tilemap tilemap;
+    typedef struct tilemap_params tilemap_params;
+    typedef struct particle_emitter particle_emitter;
+    typedef struct emitter_params emitter_params;
+    typedef struct prefab prefab;
+    typedef struct prefab_instance prefab_instance;
 
     // Camera
     typedef struct camera camera;
@@ -22,6 +22,26 @@ local Sprite = {}
 local Sprite_mt = { __index = Sprite }
 local Sprite_ct
 
+local Tilemap_t = ffi.typeof("struct{scene *scene;tilemap *map;}")
+local Tilemap = {}
+local Tilemap_mt = { __index = Tilemap }
+local Tilemap_ct
+
+local Emitter_t = ffi.typeof("struct{scene *scene;particle_emitter *em;}")
+local Emitter = {}
+local Emitter_mt = { __index = Emitter }
+local Emitter_ct
+
+local Prefab_t = ffi.typeof("struct{scene *scene;prefab *prefab;}")
+local Prefab = {}
+local Prefab_mt = { __index = Prefab }
+local Prefab_ct
+
+local PrefabInstance_t = ffi.typeof("struct{scene *scene;prefab_instance *inst;}")
+local PrefabInstance = {}
+local PrefabInstance_mt = { __index = PrefabInstance }
+local PrefabInstance_ct
+
 function Scene_mt.__new(tp, dev, gw, gh)
     local scene = check_ptr(__rd.rd_create_scene(dev.dev, gw, gh))
     return ffi_new(tp, scene)
@@ -45,6 +65,130 @@ function Scene:draw(dev, rt, cam, vp)
     check_bool(__rd.rd_draw_scene(dev.dev, rt.rt, self.scene, cam.cam, vp))
 end
 
+-- Prepares cells the camera is about to uncover over the next
+-- `frames` frames, uploading at most `budget` instances per frame
+function Scene:set_prefetch(frames, budget)
+    __rd.rd_set_scene_prefetch(self.scene, frames, budget or 2048)
+end
+
+-- Hides or shows every sprite whose tags include bit `tag` (0-31)
+function Scene:set_tag_visible(tag, visible)
+    __rd.rd_set_scene_tag_visible(self.scene, tag, visible)
+end
+
+function Scene:is_tag_visible(tag)
+    return __rd.rd_is_scene_tag_visible(self.scene, tag)
+end
+
+-- Lets sprites be created and changed from worker threads, changes are
+-- applied when the scene is next drawn or flushed
+function Scene:set_threaded(threaded)
+    __rd.rd_set_scene_threaded(self.scene, threaded)
+end
+
+function Scene:is_threaded()
+    return __rd.rd_is_scene_threaded(self.scene)
+end
+
+function Scene:flush()
+    __rd.rd_flush_scene_mutations(self.scene)
+end
+
+function Scene:get_grid_size()
+    local size = math.vec2()
+    __rd.rd_get_scene_grid_size(self.scene, size)
+    return size
+end
+
+function Scene:set_grid_size(size)
+    check_bool(__rd.rd_set_scene_grid_size(self.scene, size))
+end
+
+-- Rebuilds the grid with a cell size picked from the current sprite
+-- density, aiming for about `sprites_per_cell` sprites in each cell
+function Scene:retune_grid(sprites_per_cell)
+    check_bool(__rd.rd_retune_scene_grid(self.scene, sprites_per_cell or 64))
+end
+
+-- `format` is 'full' or 'packed'. Packed instances are half the size but
+-- store UVs, rotation/scale and layer as half floats and the tint as 8-bit.
+function Scene:set_instance_format(format)
+    local fmt
+    if format == 'packed' then
+        fmt = __rd.INSTANCE_PACKED
+    elseif format == 'full' then
+        fmt = __rd.INSTANCE_FULL
+    else
+        error("Unknown instance format")
+    end
+    __rd.rd_set_scene_instance_format(self.scene, fmt)
+end
+
+function Scene:get_instance_format()
+    if __rd.rd_get_scene_instance_format(self.scene) == __rd.INSTANCE_PACKED then
+        return 'packed'
+    end
+    return 'full'
+end
+
+local function texture_table(arrays)
+    local list = ffi_new("texture_array *[?]", #arrays)
+    for i, tary in ipairs(arrays) do
+        list[i - 1] = tary.tary
+    end
+    return list, #arrays
+end
+
+-- `arrays` is a list of TextureArrays. Snapshots store texture arrays by
+-- their index in this list, so loading must pass them in the same order.
+function Scene:save(path, arrays)
+    local list, count = texture_table(arrays)
+    check_bool(__rd.rd_save_scene(self.scene, path, list, count))
+end
+
+function Scene:load(path, arrays)
+    local list, count = texture_table(arrays)
+    check_bool(__rd.rd_load_scene(self.scene, path, list, count))
+end
+
+-- Pages far away baked sprites out to `page_file` while more than
+-- `budget` bytes of them are loaded. Pass nil to stop streaming.
+function Scene:set_streaming(page_file, budget)
+    check_bool(__rd.rd_set_scene_streaming(self.scene, page_file, budget or 0))
+end
+
+function Scene:resident_bytes()
+    return tonumber(__rd.rd_get_scene_resident_bytes(self.scene))
+end
+
+local pool_stats_t = ffi.typeof("struct pool_stats")
+-- `pool` is 'sprites' or 'prefab_instances'. Frame counts cover the time
+-- between the last two draws.
+function Scene:get_pool_stats(pool)
+    local which
+    if pool == 'sprites' then
+        which = __rd.SCENE_POOL_SPRITES
+    elseif pool == 'prefab_instances' then
+        which = __rd.SCENE_POOL_PREFAB_INSTANCES
+    else
+        error("Unknown scene pool")
+    end
+    local stats = ffi_new(pool_stats_t)
+    check_bool(__rd.rd_get_scene_pool_stats(self.scene, which, stats))
+    return {
+        live = stats.live,
+        buckets = stats.buckets,
+        reserved_bytes = tonumber(stats.reserved_bytes),
+        committed_bytes = tonumber(stats.committed_bytes),
+        free_cells = stats.free_cells,
+        frame_allocs = stats.frame_allocs,
+        frame_frees = stats.frame_frees,
+        total_allocs = tonumber(stats.total_allocs),
+        total_frees = tonumber(stats.total_frees),
+        fragmentation = stats.fragmentation,
+    }
+end
+
 local sparams_t = ffi.typeof("struct sprite_params")
 local function parse_stype(str)
     if str == 'translucent' then
@@ -62,15 +206,105 @@ local function parse_uv(uv)
     local br = uv.bottomright or math.vec2(1, 1)
     return tl, br
 end
-function Scene:create_sprite(params)
-    local sparams = ffi_new(sparams_t)
+local function fill_sparams(sparams, params)
     sparams.is_static, sparams.is_translucent = parse_stype(params.type)
     sparams.layer = params.layer or 0
     sparams.tex = params.texture.tex
     sparams.uv_topleft, sparams.uv_bottomright = parse_uv(params.uv)
     sparams.transform = params.transform or math.matrix2d.identity()
     sparams.tint = params.tint or math.color(1, 1, 1, 1)
-    return Sprite_ct(self.scene, check_ptr(__rd.rd_create_sprite(self.scene, sparams)))
+    sparams.tags = params.tags or 0
+end
+function Scene:create_sprite(params)
+    local sparams = ffi_new(sparams_t)
+    fill_sparams(sparams, params)
+    local handle = __rd.rd_create_sprite(self.scene, sparams)
+    if handle == 0 then
+        fail()
+    end
+    return Sprite_ct(self.scene, handle)
+end
+
+local sparams_array_t = ffi.typeof("struct sprite_params[?]")
+local handle_array_t = ffi.typeof("sprite_handle[?]")
+-- Creates a sprite for each entry of `list`, which holds params as taken
+-- by create_sprite. Creates either all of them or none.
+function Scene:create_sprites(list)
+    local count = #list
+    local params = ffi_new(sparams_array_t, count)
+    for i = 1, count do
+        fill_sparams(params[i - 1], list[i])
+    end
+    local handles = ffi_new(handle_array_t, count)
+    check_bool(__rd.rd_create_sprites(self.scene, params, count, handles))
+    local sprites = {}
+    for i = 1, count do
+        sprites[i] = Sprite_ct(self.scene, handles[i - 1])
+    end
+    return sprites
+end
+function Scene:destroy_sprites(sprites)
+    local handles = ffi_new(handle_array_t, #sprites)
+    local count = 0
+    for _, sprite in ipairs(sprites) do
+        if sprite.handle ~= 0 then
+            handles[count] = sprite.handle
+            count = count + 1
+            sprite.handle = 0
+        end
+    end
+    __rd.rd_destroy_sprites(self.scene, handles, count)
+end
+
+-- `children` is a list of sprite params as taken by create_sprite, with
+-- transforms relative to the prefab's root. Prefabs live as long as the
+-- scene unless destroyed explicitly.
+function Scene:create_prefab(children)
+    local count = #children
+    local list = ffi_new(sparams_array_t, count)
+    for i = 1, count do
+        fill_sparams(list[i - 1], children[i])
+    end
+    return Prefab_ct(self.scene, check_ptr(__rd.rd_create_prefab(self.scene, list, count)))
+end
+
+local tparams_t = ffi.typeof("struct tilemap_params")
+function Scene:create_tilemap(params)
+    local tparams = ffi_new(tparams_t)
+    tparams.tiles = params.tiles.tary
+    tparams.width = params.width
+    tparams.height = params.height
+    tparams.origin = params.origin or math.vec2(0, 0)
+    tparams.tile_size = params.tile_size or math.vec2(1, 1)
+    tparams.layer = params.layer or 0
+    tparams.tint = params.tint or math.color(1, 1, 1, 1)
+    return Tilemap_ct(self.scene, check_ptr(__rd.rd_create_tilemap(self.scene, tparams)))
+end
+
+local eparams_t = ffi.typeof("struct emitter_params")
+function Scene:create_emitter(params)
+    local eparams = ffi_new(eparams_t)
+    eparams.tex = params.texture.tex
+    eparams.uv_topleft, eparams.uv_bottomright = parse_uv(params.uv)
+    eparams.position = params.position or math.vec2(0, 0)
+    eparams.velocity_min = params.velocity_min or math.vec2(0, 0)
+    eparams.velocity_max = params.velocity_max or eparams.velocity_min
+    eparams.acceleration = params.acceleration or math.vec2(0, 0)
+    eparams.lifetime_min = params.lifetime_min or 1
+    eparams.lifetime_max = params.lifetime_max or eparams.lifetime_min
+    eparams.size_start = params.size_start or 1
+    eparams.size_end = params.size_end or eparams.size_start
+    eparams.color_start = params.color_start or math.color(1, 1, 1, 1)
+    eparams.color_end = params.color_end or eparams.color_start
+    eparams.layer = params.layer or 0
+    eparams.emit_rate = params.emit_rate or 0
+    eparams.max_particles = params.max_particles or 1024
+    return Emitter_ct(self.scene, check_ptr(__rd.rd_create_emitter(self.scene, eparams)))
+end
+
+-- Advances every emitter in the scene by `dt` seconds
+function Scene:update_particles(dt)
+    __rd.rd_update_particles(self.scene, dt)
 end
 
 function Sprite_mt:__gc()
@@ -78,16 +312,114 @@ function Sprite_mt:__gc()
 end
 
 function Sprite:destroy()
-    if self.handle ~= nil then
+    if self.handle ~= 0 then
         __rd.rd_destroy_sprite(self.scene, self.handle)
-        self.handle = nil
+        self.handle = 0
+    end
+end
+
+function Sprite:is_hidden()
+    return __rd.rd_is_sprite_hidden(self.scene, self.handle)
+end
+
+function Sprite:set_hidden(hidden)
+    __rd.rd_set_sprite_hidden(self.scene, self.handle, hidden)
+end
+
+function Sprite:get_tags()
+    return __rd.rd_get_sprite_tags(self.scene, self.handle)
+end
+
+function Sprite:set_tags(tags)
+    __rd.rd_set_sprite_tags(self.scene, self.handle, tags)
+end
+
+function Prefab:destroy()
+    if self.prefab ~= nil then
+        check_bool(__rd.rd_destroy_prefab(self.scene, self.prefab))
+        self.prefab = nil
+    end
+end
+
+function Prefab:instantiate(transform)
+    local inst = check_ptr(__rd.rd_instantiate_prefab(self.scene, self.prefab, transform))
+    return PrefabInstance_ct(self.scene, inst)
+end
+
+function PrefabInstance_mt:__gc()
+    self:destroy()
+end
+
+function PrefabInstance:destroy()
+    if self.inst ~= nil then
+        __rd.rd_destroy_prefab_instance(self.scene, self.inst)
+        self.inst = nil
+    end
+end
+
+function PrefabInstance:set_transform(transform)
+    __rd.rd_set_prefab_instance_transform(self.scene, self.inst, transform)
+end
+
+function Tilemap_mt:__gc()
+    self:destroy()
+end
+
+function Tilemap:destroy()
+    if self.map ~= nil then
+        __rd.rd_destroy_tilemap(self.scene, self.map)
+        self.map = nil
     end
 end
 
+function Tilemap:get(x, y)
+    return __rd.rd_get_tile(self.scene, self.map, x, y)
+end
+
+function Tilemap:set(x, y, tile)
+    __rd.rd_set_tile(self.scene, self.map, x, y, tile)
+end
+
+-- `tiles` is a row-major uint16_t array of w * h tiles
+function Tilemap:set_region(x, y, w, h, tiles)
+    __rd.rd_set_tile_region(self.scene, self.map, x, y, w, h, tiles)
+end
+
+function Emitter_mt:__gc()
+    self:destroy()
+end
+
+function Emitter:destroy()
+    if self.em ~= nil then
+        __rd.rd_destroy_emitter(self.scene, self.em)
+        self.em = nil
+    end
+end
+
+function Emitter:set_position(pos)
+    __rd.rd_set_emitter_position(self.scene, self.em, pos)
+end
+
+function Emitter:count()
+    return __rd.rd_get_particle_count(self.scene, self.em)
+end
+
+function Emitter:emit(count)
+    __rd.rd_emit_particles(self.scene, self.em, count)
+end
+
 Scene_ct = ffi.metatype(Scene_t, Scene_mt)
 Sprite_ct = ffi.metatype(Sprite_t, Sprite_mt)
+Tilemap_ct = ffi.metatype(Tilemap_t, Tilemap_mt)
+Emitter_ct = ffi.metatype(Emitter_t, Emitter_mt)
+Prefab_ct = ffi.metatype(Prefab_t, Prefab_mt)
+PrefabInstance_ct = ffi.metatype(PrefabInstance_t, PrefabInstance_mt)
 
 return {
     Scene = Scene_ct,
     Sprite = Sprite_ct,
+    Tilemap = Tilemap_ct,
+    Emitter = Emitter_ct,
+    Prefab = Prefab_ct,
+    PrefabInstance = PrefabInstance_ct,
 }
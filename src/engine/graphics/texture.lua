@@ -3,6 +3,7 @@ local rd_err = require("engine.graphics.error")
 
 local C = ffi.C
 local check_ptr = rd_err.check_ptr
+local check_bool = rd_err.check_bool
 local ffi_new = ffi.new
 local ffi_cast = ffi.cast
 local ffi_gc = ffi.gc
@@ -64,6 +65,13 @@ function TextureArray:destroy()
     end
 end
 
+-- Draws from `lower` while the camera shows at most `max_pixels_per_unit`
+-- screen pixels per world unit. Keep `lower` alive as long as it's linked.
+function TextureArray:set_lod(lower, max_pixels_per_unit)
+    local tary = lower and lower.tary or nil
+    check_bool(__rd.rd_set_texture_array_lod(self.tary, tary, max_pixels_per_unit or 0))
+end
+
 function TextureArray:get(i)
     local tex = check_ptr(__rd.rd_get_texture(self.tary, i))
     return Texture_ct(tex)
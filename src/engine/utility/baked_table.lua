@@ -0,0 +1,153 @@
+local bit = require("bit")
+local module = {}
+
+local bit_xor = bit.bxor
+local bit_lsl = bit.lshift
+local tobit = bit.tobit
+
+-- Same as fnv1a_32 in backends/common/hash.h
+local function fnv1a_32(str, basis)
+    local state = tobit(basis or 2166136261)
+    for i = 1, #str do
+        state = bit_xor(state, string.byte(str, i))
+        -- state * 16777619, split so the product stays exact in a double
+        state = tobit(bit_lsl(state, 24) + state * 403)
+    end
+    return state % 4294967296
+end
+module.fnv1a_32 = fnv1a_32
+
+-- Maps a hash onto [0, count) by its high bits, like baked_table::scale
+local function scale(hash, count)
+    return math.floor(hash * count / 4294967296)
+end
+
+-- Finds a perfect hash for `names` (hash and displace): every name's hash
+-- picks a bucket, and each bucket gets a seed that sends its names to free
+-- slots. Fullest buckets go first while most slots are still free, and a
+-- bucket of one stores its slot outright. Returns the name index for each
+-- slot and the seed for each bucket, both zero based.
+local function place(names)
+    local count = #names
+    local buckets = {}
+    for i = 0, count - 1 do
+        buckets[i + 1] = { index = i }
+    end
+    local seen = {}
+    for i, name in ipairs(names) do
+        if seen[name] then
+            error("Baked name `"..name.."` is used twice")
+        end
+        seen[name] = true
+        local bucket = buckets[scale(fnv1a_32(name), count) + 1]
+        bucket[#bucket + 1] = i
+    end
+    table.sort(buckets, function(a, b)
+        if #a ~= #b then
+            return #a > #b
+        end
+        return a.index < b.index
+    end)
+
+    local slots, seeds = {}, {}
+    for i = 0, count - 1 do
+        seeds[i] = 0
+    end
+
+    local free = 0
+    for _, bucket in ipairs(buckets) do
+        if #bucket > 1 then
+            local seed = 1
+            while true do
+                local taken = {}
+                local fits = true
+                for _, i in ipairs(bucket) do
+                    local slot = scale(fnv1a_32(names[i], seed), count)
+                    if slots[slot] or taken[slot] then
+                        fits = false
+                        break
+                    end
+                    taken[slot] = i
+                end
+                if fits then
+                    for slot, i in pairs(taken) do
+                        slots[slot] = i
+                    end
+                    seeds[bucket.index] = seed
+                    break
+                end
+                seed = seed + 1
+                if seed > 0x7FFFFFFF then
+                    error("No perfect hash found for the baked names")
+                end
+            end
+        elseif #bucket == 1 then
+            while slots[free] do
+                free = free + 1
+            end
+            slots[free] = bucket[1]
+            seeds[bucket.index] = -(free + 1)
+        end
+    end
+
+    return slots, seeds
+end
+
+local function write_bytes(file, data)
+    local line = {}
+    for i = 1, #data, 16 do
+        for j = i, math.min(i + 15, #data) do
+            line[#line + 1] = string.format("0x%02X,", string.byte(data, j))
+        end
+        file:write(table.concat(line), "\n")
+        for j = #line, 1, -1 do
+            line[j] = nil
+        end
+    end
+end
+
+-- Writes the C++ definition of a `baked_table` (backends/common/baked_table.h)
+-- called `table_name` holding `blobs`, a list of { name = ..., data = ... }.
+-- The including file must already have the baked_table declarations.
+function module.write(file, table_name, blobs)
+    if #blobs == 0 then
+        file:write("extern const baked_table ", table_name, " = { nullptr, nullptr, 0 };\n")
+        return
+    end
+
+    local names = {}
+    for i, blob in ipairs(blobs) do
+        names[i] = blob.name
+    end
+    local slots, seeds = place(names)
+
+    for i, blob in ipairs(blobs) do
+        file:write("static const uint8_t ", table_name, "_", i, "[] = {\n")
+        if #blob.data == 0 then
+            file:write("0\n")
+        end
+        write_bytes(file, blob.data)
+        file:write("};\n")
+    end
+    file:write("\n")
+
+    file:write("static const baked_blob ", table_name, "_entries[] = {\n")
+    for slot = 0, #blobs - 1 do
+        local i = slots[slot]
+        local name = string.gsub(blobs[i].name, '[\\"]', '\\%0')
+        file:write('    { "', name, '", ', table_name, "_", i, ", ", #blobs[i].data, " },\n")
+    end
+    file:write("};\n\n")
+
+    file:write("static const int32_t ", table_name, "_seeds[] = {\n")
+    for i = 0, #blobs - 1 do
+        file:write("    ", seeds[i], ",\n")
+    end
+    file:write("};\n\n")
+
+    file:write("extern const baked_table ", table_name, " = {\n")
+    file:write("    ", table_name, "_entries, ", table_name, "_seeds, ", #blobs, "\n")
+    file:write("};\n")
+end
+
+return module
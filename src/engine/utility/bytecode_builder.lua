@@ -1,9 +1,11 @@
 local path = require("engine.utility.path")
+local baked_table = require("engine.utility.baked_table")
 local io = require("io")
 
 local module = {}
 
 local bfile
+local blobs
 
 local function start_build()
     local err
@@ -14,15 +16,14 @@ local function start_build()
 
     bfile:write[[
 #include "bytecode.h"
-using namespace std::string_literals;
 
-std::unordered_map<std::string, std::string> baked_bytecode =
-std::unordered_map<std::string, std::string> {
 ]]
+    blobs = {}
 end
 
 local function end_build()
-    bfile:write("};\n")
+    baked_table.write(bfile, "baked_bytecode", blobs)
+    bfile:write("\n")
 end
 
 local function build_file(path, mod_name)
@@ -41,17 +42,7 @@ local function build_file(path, mod_name)
         return
     end
 
-    local data = string.dump(func, true)
-
-    bfile:write('{"')
-    bfile:write(mod_name)
-    bfile:write('"s,"')
-
-    for i = 1, #data do
-        bfile:write(string.format("\\x%02X", string.byte(data, i)))
-    end
-
-    bfile:write('"s},\n')
+    blobs[#blobs + 1] = { name = mod_name, data = string.dump(func, true) }
 end
 
 local function inner_mod(item, mod_name)
@@ -122,11 +113,11 @@ local function list_dir(path, i)
         if item:is_file() and item:extension() == 'lua' then
             bfile:write('"')
             bfile:write(item:file_stem())
-            bfile:write('"s,')
+            bfile:write('",')
         elseif item:is_dir() and path.join(item, "init.lua"):exists() then
             bfile:write('"')
             bfile:write(item:file_name())
-            bfile:write('"s,')
+            bfile:write('",')
         end
     end
     bfile:write("},\n")
@@ -138,7 +129,7 @@ local function list_dir(path, i)
             indent(i + 2)
             bfile:write('{"')
             bfile:write(item:file_name())
-            bfile:write('"s, ')
+            bfile:write('", ')
             list_dir(item, i + 2)
             bfile:write("},\n")
         end
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <backends/common/baked_table.h>
 #include <string>
 #include <unordered_set>
 #include <unordered_map>
@@ -17,6 +18,6 @@ struct bytecode_listing
     std::unordered_map<std::string, bytecode_listing> subdirs;
 };
 
-extern std::unordered_map<std::string, std::string> baked_bytecode;
+extern const baked_table baked_bytecode;
 extern bytecode_listing bytecode_list;
 
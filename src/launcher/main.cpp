@@ -1,21 +1,20 @@
 #include <lua.hpp>
-#include <unordered_map>
-#include <string>
 #include <iostream>
 
 #ifdef BAKED_CODE
-extern std::unordered_map<std::string, std::string> baked_bytecode;
+#include "bytecode.h"
 static void inject_baked(lua_State *L)
 {
     lua_getfield(L, LUA_GLOBALSINDEX, "package");
     lua_getfield(L, -1, "preload");
 
-    for (auto &pair : baked_bytecode)
+    for (auto &blob : baked_bytecode)
     {
-        lua_pushlstring(L, pair.first.c_str(), pair.first.size());
-        if (luaL_loadbuffer(L, pair.second.c_str(), pair.second.size(), pair.first.c_str()))
+        lua_pushstring(L, blob.name);
+        auto code = reinterpret_cast<const char *>(blob.data);
+        if (luaL_loadbuffer(L, code, blob.size, blob.name))
         {
-            std::cerr << "Failed to load `" << pair.first << "` bytecode" << std::endl;
+            std::cerr << "Failed to load `" << blob.name << "` bytecode" << std::endl;
             std::cerr << lua_tostring(L, -1) << std::endl;
             exit(1);
         }
@@ -34,8 +33,15 @@ int main(int argc, char **argv)
 #ifdef BAKED_CODE
 
     inject_baked(L);
-    auto &engine = baked_bytecode["main"];
-    if (luaL_loadbuffer(L, engine.c_str(), engine.size(), "main"))
+    auto engine = baked_bytecode.find("main");
+    if (!engine)
+    {
+        std::cerr << "`main` is missing from the baked bytecode" << std::endl;
+        lua_close(L);
+        return 1;
+    }
+    auto code = reinterpret_cast<const char *>(engine->data);
+    if (luaL_loadbuffer(L, code, engine->size, "main"))
     {
         std::cerr << "Failed to load `main` bytecode" << std::endl;
         std::cerr << lua_tostring(L, -1) << std::endl;
@@ -43,7 +49,7 @@ int main(int argc, char **argv)
         return 1;
     }
     lua_pushliteral(L, "--skip-package-bs");
-    for (int i = 1; i < argc; ++argv)
+    for (int i = 1; i < argc; ++i)
     {
         lua_pushstring(L, argv[i]);
     }